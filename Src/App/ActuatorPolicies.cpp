@@ -0,0 +1,76 @@
+/*
+  * Output policies of the actuators
+    * What the alarm, the relay and the relay bank events do with the output pins,
+    * the speaker and the main screen. They are bound at compile time
+    * through TimeWindowActuator<Policy>::Apply.
+*/
+
+#include "../Clock/Alarm.hpp"
+#include "../Clock/Relay.hpp"
+#include "../Clock/RelayBank.hpp"
+#include "../Drivers/PiezoSound.hpp"
+#include "../Drivers/GPIOControl.hpp"
+#include "../UserInterface/MainScreen.hpp"
+
+void AlarmPolicy::SetOutput(GPIOControl& gpio, bool on)
+{
+    if (on) {
+        gpio.AlarmOn();
+    } else {
+        gpio.AlarmOff();
+    }
+}
+
+void AlarmPolicy::PlayFeedback(PiezoSound& sound, ActuatorEventType type)
+{
+    // A missed alarm chirps as well, so the jump over it is noticed
+    if (type == ActuatorEventType::On || type == ActuatorEventType::Missed) {
+        // sound.PlayAlarmStart(); // Play alarm sound
+        // sound.PlayHourlyCuckoo(); // Play hourly cuckoo sound
+        sound.PlayMenuBeep(); // Play a menu beep sound
+    } else if (type == ActuatorEventType::Off) {
+        sound.StopAlarm(); // Silence the alarm sound if it still plays
+    }
+}
+
+void AlarmPolicy::ShowEvent(MainScreen& mainScreen, const ActuatorEvent<AlarmConfig>& evt)
+{
+    if (evt.type == ActuatorEventType::On || evt.type == ActuatorEventType::Off) {
+        mainScreen.SetAlarmState(evt.state, false);  // Later we can add a render flag
+    }
+    mainScreen.SetAlarmConfig(evt.config, false); // Show the next alarm
+}
+
+void RelayPolicy::SetOutput(GPIOControl& gpio, bool on)
+{
+    if (on) {
+        gpio.RelayOn();
+    } else {
+        gpio.RelayOff();
+    }
+}
+
+void RelayPolicy::PlayFeedback(PiezoSound& sound, ActuatorEventType type)
+{
+    if (type == ActuatorEventType::On || type == ActuatorEventType::Off) {
+        sound.PlayMenuBeep(); // Play a menu beep sound
+    }
+}
+
+void RelayPolicy::ShowEvent(MainScreen& mainScreen, const ActuatorEvent<RelayConfig>& evt)
+{
+    if (evt.type == ActuatorEventType::Reconfigured) {
+        mainScreen.SetRelayConfig(evt.config, false); // Update the relay config
+    } else if (evt.type != ActuatorEventType::Missed) {
+        mainScreen.SetRelayState(evt.state, false);  // Later we can add a render flag
+    }
+}
+
+void RelayBank::Apply(const ActuatorOutputs& outputs, const RelayBankEvent& evt)
+{
+    if (evt.type == RelayBankEventType::Changed) {
+        outputs.gpio->SetRelayBank(evt.state.mask); // All the channels in one write
+        outputs.sound->PlayMenuBeep(); // Play a menu beep sound
+    }
+    outputs.mainScreen->SetRelayBankState(evt.state, false);
+}
@@ -6,6 +6,8 @@
 #include "../Clock/Clock.hpp"
 #include "../Clock/Alarm.hpp"
 #include "../Clock/Relay.hpp"
+#include "../Clock/RelayBank.hpp"
+#include "../Clock/Thermostat.hpp"
 #include "../Drivers/HD44780.hpp"
 #include "../Display/Display.hpp"
 #include "../Display/IDisplay.hpp"
@@ -25,32 +27,36 @@ struct UiTaskContext {
     MenuController* menu;
 };
 
-struct ClockTaskContext {
-    QueueHandle_t queue;
-    GPIOControl gpio;
-    MainScreen* mainScreen;
-    MenuController* menu;
+struct ScheduleTaskContext {
+    QueueHandle_t queue;        // Clock ticks
+    QueueHandle_t renderQueue;  // Latest tick for the display, single slot
+    Clock* clock;
     Relay* relay;
     Alarm* alarm;
+    RelayBank* bank;
 };
 
-struct AlarmTaskContext {
+struct ClockTaskContext {
     QueueHandle_t queue;
-    MainScreen mainScreen;
-    PiezoSound sound;
-    GPIOControl gpio;
+    GPIOControl* gpio;
+    MainScreen* mainScreen;
+    MenuController* menu;
 };
 
-struct RelayTaskContext {
-    QueueHandle_t queue;
-    MainScreen mainScreen;
-    PiezoSound sound;
-    GPIOControl gpio;
+struct ActuatorTaskContext {
+    QueueSetHandle_t queueSet;  // Event queues of all the actuators
+    Alarm* alarm;
+    Relay* relay;
+    RelayBank* bank;
+    ActuatorOutputs outputs;
 };
 
 struct SystemThermoTaskContext {
     QueueHandle_t queue;
     MainScreen* mainScreen;
+    Thermostat* thermostat;
+    Relay* relay;
+    Clock* clock;
 };
 
 static void UserInterfaceTask(void *param) {
@@ -59,107 +65,109 @@ static void UserInterfaceTask(void *param) {
     MenuController* menu = ctx->menu;
 
     EncoderEvent clockEvent;
+    EncoderEvent next;
 
     while (true) {
         if (xQueueReceive(queue, &clockEvent, portMAX_DELAY)) {
 
-            // Convert EncoderEvent to MenuEvent
-            MenuEvent menuEvt;
-            switch (clockEvent.type) {
-                case EncoderEventType::RotatedR:
-                    menuEvt = MenuEvent::MoveFwd;
-                    break;
-                case EncoderEventType::RotatedL:
-                    menuEvt = MenuEvent::MoveBack;
-                    break;
-                case EncoderEventType::Pressed:
-                    menuEvt = MenuEvent::PushButton;
-                    break;
-                default:
-                    continue; // Ignore unknown events
+            // Fold in the rotations which queued up during the last
+            // render, so one render covers all of them
+            uint32_t merged = 0;
+            while (xQueuePeek(queue, &next, 0) && clockEvent.Merge(next)) {
+                xQueueReceive(queue, &next, 0);
+                merged++;
             }
 
-            // Process the menu event
-            menu->ProcessEvent(menuEvt);
+            // Convert EncoderEvent to MenuEvent and process it
+            menu->ProcessEncoderEvent(clockEvent, merged);
         }
     }
 }
 
-void AlarmTask(void* param) {
-    AlarmTaskContext* ctx = static_cast<AlarmTaskContext*>(param);
-    MainScreen* mainScreen = &ctx->mainScreen;
-    GPIOControl* gpio = &ctx->gpio;
-    PiezoSound* sound = &ctx->sound;
-    QueueHandle_t queue = ctx->queue;
+// Apply the pending event if the queue belongs to the actuator
+template <typename Actuator>
+static bool ApplyActuatorEvent(const Actuator* actuator, QueueSetMemberHandle_t member, const ActuatorOutputs& outputs) {
+    if (member != actuator->GetEventQueue()) {
+        return false;
+    }
+
+    typename Actuator::Event evt;
+    if (xQueueReceive(member, &evt, 0)) {
+        Actuator::Apply(outputs, evt);
+    }
+    return true;
+}
+
+void ActuatorTask(void* param) {
+    ActuatorTaskContext* ctx = static_cast<ActuatorTaskContext*>(param);
 
     while (true) {
-        AlarmEvent alarmEvent;
-        if (xQueueReceive(queue, &alarmEvent, portMAX_DELAY)) {
-            switch (alarmEvent.type) {
-                case AlarmEventType::AlarmOn:
-                    gpio->AlarmOn();
-                    mainScreen->SetAlarmState(alarmEvent.state, false);  // Later we can add a render flag
-                    // sound->PlayAlarmStart(); // Play alarm sound
-                    // sound->PlayHourlyCuckoo(); // Play hourly cuckoo sound
-                    // sound->PlaySweep(); // Play a sweep sound
-                    sound->PlayMenuBeep(); // Play a menu beep sound
-                    // sound->PlayHatikvah(); // Play Hatikvah melody
-                    break;
-
-                case AlarmEventType::AlarmOff:
-                    gpio->AlarmOff();
-                    mainScreen->SetAlarmState(alarmEvent.state, false);  // Later we can add a render flag
-                    break;
-
-                case AlarmEventType::Reconfigured:
-                    // Handle reconfiguration if needed
-                    mainScreen->SetAlarmConfig(alarmEvent.config, false); // Update the alarm config
-                    break;
-            }
-        }
+        QueueSetMemberHandle_t member = xQueueSelectFromSet(ctx->queueSet, portMAX_DELAY);
+
+        // A new actuator type only adds its line here
+        ApplyActuatorEvent(ctx->alarm, member, ctx->outputs) ||
+        ApplyActuatorEvent(ctx->relay, member, ctx->outputs) ||
+        ApplyActuatorEvent(ctx->bank, member, ctx->outputs);
     }
 }
 
-void RelayTask(void* param) {
-    RelayTaskContext* ctx = static_cast<RelayTaskContext*>(param);
-    MainScreen* mainScreen = &ctx->mainScreen;
-    GPIOControl* gpio = &ctx->gpio;
-    PiezoSound* sound = &ctx->sound;
+void ScheduleTask(void* param) {
+    ScheduleTaskContext* ctx = static_cast<ScheduleTaskContext*>(param);
     QueueHandle_t queue = ctx->queue;
+    QueueHandle_t renderQueue = ctx->renderQueue;
+    Clock* clock = ctx->clock;
+    Relay* relay = ctx->relay;
+    Alarm* alarm = ctx->alarm;
+    RelayBank* bank = ctx->bank;
 
     while (true) {
-        RelayEvent relayEvent;
-        if (xQueueReceive(queue, &relayEvent, portMAX_DELAY)) {
-            switch (relayEvent.type) {
-                case RelayEventType::RelayOn:
-                    gpio->RelayOn();
-                    mainScreen->SetRelayState(relayEvent.state, false);  // Later we can add a render flag
-                    sound->PlayMenuBeep(); // Play a menu beep sound
-                    break;
-
-                case RelayEventType::RelayOff:
-                    gpio->RelayOff();
-                    mainScreen->SetRelayState(relayEvent.state, false);  // Later we can add a render flag
-                    sound->PlayMenuBeep(); // Play a menu beep sound
-                    break;
-
-                case RelayEventType::Reconfigured:
-                    // Handle reconfiguration if needed
-                    mainScreen->SetRelayConfig(relayEvent.config, false); // Update the relay config
-                    break;
+        ClockEvent clockEvent;
+        if (xQueueReceive(queue, &clockEvent, portMAX_DELAY)) {
+
+            // The schedule is evaluated on every clock event,
+            // no matter what the user interface is doing
+            if (clockEvent.type == ClockEventType::TimeJump) {
+                // Account for the windows skipped by the jump at once
+                alarm->CatchUp(clockEvent.previousTime, clockEvent.currentTime);
+                relay->CatchUp(clockEvent.previousTime, clockEvent.currentTime);
+                bank->CatchUp(clockEvent.previousTime, clockEvent.currentTime);
+            } else {
+                alarm->ProcessCurrentTime(clockEvent.currentTime);
+                relay->ProcessCurrentTime(clockEvent.currentTime);
+                bank->ProcessCurrentTime(clockEvent.currentTime);
+            }
+
+            // Sleep until the nearest alarm, relay or relay bank transition
+            DateTime next = alarm->NextTransition(clockEvent.currentTime);
+            DateTime relayNext = relay->NextTransition(clockEvent.currentTime);
+            DateTime bankNext = bank->NextTransition(clockEvent.currentTime);
+            if (relayNext < next) {
+                next = relayNext;
+            }
+            if (bankNext < next) {
+                next = bankNext;
+            }
+            clock->SetWakeupTime(next);
+
+            if (clockEvent.type == ClockEventType::Reschedule ||
+                clockEvent.type == ClockEventType::TimeJump) {
+                // Nothing has changed for the display
+                continue;
             }
+
+            // Hand the tick over to the display; if it did not
+            // catch up with the previous one, that one is dropped
+            xQueueOverwrite(renderQueue, &clockEvent);
         }
     }
 }
 
 void ClockDisplayTask(void* param) {
     ClockTaskContext* ctx = static_cast<ClockTaskContext*>(param);
-    GPIOControl* gpio = &ctx->gpio;
+    GPIOControl* gpio = ctx->gpio;
     QueueHandle_t queue = ctx->queue;
     MainScreen* mainScreen = ctx->mainScreen;
     MenuController* menu = ctx->menu;
-    Relay* relay = ctx->relay;
-    Alarm* alarm = ctx->alarm;
 
     while (true) {
         ClockEvent clockEvent;
@@ -172,16 +180,9 @@ void ClockDisplayTask(void* param) {
                 continue;
             }
             
-            if (clockEvent.type != ClockEventType::Tick) {
-                // Ignore non-tick events
-                continue;
-            }
-
             // Process the clock event
             {
                 gpio->BlinkTickLed();
-                alarm->ProcessCurrentTime(clockEvent.currentTime);
-                relay->ProcessCurrentTime(clockEvent.currentTime);
 
                 mainScreen->SetClockTime(clockEvent.currentTime, false);
 
@@ -195,12 +196,31 @@ void SystemThermoTask(void* param) {
     SystemThermoTaskContext* ctx = static_cast<SystemThermoTaskContext*>(param);
     QueueHandle_t queue = ctx->queue;
     MainScreen* mainScreen = ctx->mainScreen;
+    Thermostat* thermostat = ctx->thermostat;
+
+    float temperature = 0.0f;
+    TickType_t wait = portMAX_DELAY;
 
     while (true) {
+        // A timeout means a switch held back by the
+        // minimum on/off time is due, with the last reading
         TemperatureEvent tempEvent;
-        if (xQueueReceive(queue, &tempEvent, portMAX_DELAY)) {
+        if (xQueueReceive(queue, &tempEvent, wait)) {
             mainScreen->SetTemperature(tempEvent.temperatureC, false);
+            temperature = tempEvent.temperatureC;
+        }
+
+        uint32_t nowMs = xTaskGetTickCount() * portTICK_PERIOD_MS;
+        bool demand = thermostat->GetDemand();
+        if (thermostat->Update(temperature, nowMs) != demand) {
+            ctx->relay->UpdateMatcher([demand](RelayMatcher& matcher) {
+                matcher.SetDemand(!demand);
+            });
+            ctx->clock->RequestReschedule(); // The schedule task switches the relay
         }
+
+        uint32_t holdMs = thermostat->GetHoldRemainingMs(nowMs);
+        wait = (holdMs > 0) ? pdMS_TO_TICKS(holdMs) : portMAX_DELAY;
     }
 }
 
@@ -210,7 +230,7 @@ int main() {
 
 
     HD44780 lcd(0x27); // This address is common for many I2C LCDs, but it may vary.
-    lcd.Init();
+    lcd.Init(true); // Poll the busy flag, falls back to the fixed delays if R/W is not wired
     lcd.Clear();
 
     MenuContent menuContent;
@@ -219,7 +239,8 @@ int main() {
     MainScreen mainScreen(&display);
     MenuScreen menuScreen(&display, &menuContent);
 
-    RotaryEncoder encoder(14, 15, 13);
+    // Decoded by PIO, R is the pin after L
+    RotaryEncoder encoder(14, 15, 13, EncoderDecoder::Pio);
     encoder.Init();
 
     PiezoSound sound(8);
@@ -227,40 +248,86 @@ int main() {
     // LED pin, Alarm control pin, Relay control pin
     GPIOControl gpio(PICO_DEFAULT_LED_PIN, 6, 9);
 
-    // Create Alarm instance
-    Alarm alarm(4);
+    // Relay bank pins, 8 channels; the channels turning on
+    // at the same minute are switched 50 ms apart
+    static const uint8_t bankPins[RelayBank::MaxChannels] = {16, 17, 18, 19, 20, 21, 22, 26};
+    gpio.SetRelayBankPins(bankPins, RelayBank::MaxChannels, 50);
+
+    // Create the actuators; their event queues have to be
+    // added to the set while they are still empty
+    static Alarm alarm(4); // static, main has a small stack
+    static Relay relay(4);  // static, the schedules take 10 KB
+    static RelayBank bank(RelayBank::MaxChannels, 4); // static, the schedules take 10 KB
+    QueueSetHandle_t actuatorQueues = xQueueCreateSet(4 + 4 + 4);
+    xQueueAddToSet(alarm.GetEventQueue(), actuatorQueues);
+    xQueueAddToSet(relay.GetEventQueue(), actuatorQueues);
+    xQueueAddToSet(bank.GetEventQueue(), actuatorQueues);
+
+    // Configure Alarm instance
     {
         AlarmConfig alarmConfig;
-        alarm.GetAlarmConfig(alarmConfig);
+        alarm.GetConfig(0, alarmConfig);
         
         // Set default alarm time and duration
-        alarmConfig.timeBeg = {0, 0, 0, 12, 0, 0}; // Set default alarm time
+        alarmConfig.timeBeg = {2025, 1, 1, 12, 0, 0}; // Set default alarm time
         alarmConfig.duration = 10; // Set default alarm length
         alarmConfig.enabled = true; // Enable the alarm by default
-        alarm.SetAlarmConfig(alarmConfig);
+        alarmConfig.weekdays = AlarmConfig::AllDays; // Ring every day
+        alarm.SetConfig(0, alarmConfig);
         mainScreen.SetAlarmConfig(alarmConfig, false);
     }
 
-    // Create Relay instance
-    Relay relay(4);
+    // Configure Relay instance
     {
         RelayConfig relayConfig;
-        relay.GetRelayConfig(relayConfig);
+        relay.GetConfig(0, relayConfig);
 
         // Set default relay times
         relayConfig.timeBeg = {2025, 1, 1, 12, 0, 0}; // Start at 12:00
         relayConfig.timeEnd = {2025, 1, 1, 12, 1, 0}; // End at 12:01
         relayConfig.enabled = true; // Enable the relay by default
-        relay.SetRelayConfig(relayConfig);
+        relay.SetConfig(0, relayConfig);
         mainScreen.SetRelayConfig(relayConfig, false);
     }
 
+    // Thermostat mode of the relay; while it is off
+    // the relay follows its windows as before
+    static Thermostat thermostat;
+    {
+        ThermostatConfig thermostatConfig;
+        thermostatConfig.enabled = false;   // Enable to drive the relay by the temperature
+        thermostatConfig.cooling = false;   // Heating: on below the setpoint
+        thermostatConfig.gated = true;      // Only inside the relay windows
+        thermostatConfig.setpoint = 20.0f;
+        thermostatConfig.hysteresis = 1.0f;
+        thermostatConfig.minOnSeconds = 120;
+        thermostatConfig.minOffSeconds = 120;
+
+        thermostat.SetConfig(thermostatConfig);
+        relay.UpdateMatcher([&thermostatConfig](RelayMatcher& matcher) {
+            matcher.SetThermostatMode(thermostatConfig);
+        });
+    }
+
+    // Configure the relay bank channels
+    {
+        RelayWindow window;
+        RelaySchedule::ParseWindow("Mo-Fr 07:00-19:00", window);
+        bank.SetWindows(0, &window, 1);
+        RelaySchedule::ParseWindow("Sa,Su 22:00-06:00", window);
+        bank.SetWindows(1, &window, 1);
+    }
+
     // Create Clock instance
     Clock clock(4); // static so it persists
 
     // Optional: initialize time and alarm
     clock.SetCurrentTime({2025, 6, 19, 11, 59, 55});
 
+    // Seconds on the main screen; on unattended units use 60
+    // (minute updates) or 0 to wake only on alarm/relay transitions
+    clock.SetTickInterval(1);
+
     SystemThermo thermo(0.01f, 2000, 4);
     thermo.Start(); // Start the temperature reading task
 
@@ -271,45 +338,54 @@ int main() {
         .menu = &menu
     };
 
-    AlarmTaskContext alarmCtx = {
-        .queue = alarm.GetEventQueue(),
-        .mainScreen = mainScreen,
-        .sound = sound,
-        .gpio = gpio,
+    static ActuatorTaskContext actuatorCtx = {
+        .queueSet = actuatorQueues,
+        .alarm = &alarm,
+        .relay = &relay,
+        .bank = &bank,
+        .outputs = {
+            .gpio = &gpio,
+            .sound = &sound,
+            .mainScreen = &mainScreen,
+        },
     };
 
-    RelayTaskContext relayCtx = {
-        .queue = relay.GetEventQueue(),
-        .mainScreen = mainScreen,
-        .sound = sound,
-        .gpio = gpio,
+    static ScheduleTaskContext scheduleCtx = {
+        .queue = clock.GetEventQueue(),
+        .renderQueue = xQueueCreate(1, sizeof(ClockEvent)),
+        .clock = &clock,
+        .relay = &relay,
+        .alarm = &alarm,
+        .bank = &bank,
     };
 
     static ClockTaskContext clockCtx = {
-        .queue = clock.GetEventQueue(),
-        .gpio = gpio,
+        .queue = scheduleCtx.renderQueue,
+        .gpio = &gpio,
         .mainScreen = &mainScreen,
         .menu = &menu,
-        .relay = &relay,
-        .alarm = &alarm,
     };
 
     static SystemThermoTaskContext thermoCtx = {
         .queue = thermo.GetEventQueue(),
-        .mainScreen = &mainScreen
+        .mainScreen = &mainScreen,
+        .thermostat = &thermostat,
+        .relay = &relay,
+        .clock = &clock,
     };
 
     // Start Encoder task
     xTaskCreate(UserInterfaceTask, "UserInterface", 512, &uiCtx, 1, nullptr);
 
+    // Start Schedule task, above the UI tasks so the alarm
+    // and relay never wait for the display or the menu
+    xTaskCreate(ScheduleTask, "Schedule", 512, &scheduleCtx, 3, nullptr);
+
     // Start Clock UI display task
     xTaskCreate(ClockDisplayTask, "ClockDisplay", 1024, &clockCtx, 1, nullptr);
 
-    // Start Alarm task
-    xTaskCreate(AlarmTask, "AlarmTask", 512, &alarmCtx, 1, nullptr);
-
-    // Start Relay task
-    xTaskCreate(RelayTask, "RelayTask", 512, &relayCtx, 1, nullptr);
+    // Start Actuator task, shared by the alarm and the relay
+    xTaskCreate(ActuatorTask, "Actuators", 512, &actuatorCtx, 1, nullptr);
 
     // Start SystemThermo task
     xTaskCreate(SystemThermoTask, "SystemThermo", 512, &thermoCtx, 1, nullptr);
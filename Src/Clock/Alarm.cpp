@@ -1,48 +1,281 @@
 /*
   * Alarm Class
+    * Holds up to MaxAlarms daily alarms, each with its own time,
+    * duration, enable flag and weekday mask.
+    * The enabled alarms are kept in a binary min-heap ordered by
+    * their next fire time, so a tick only compares the current time
+    * with the head of the heap and a reconfiguration costs O(log n).
+    * The state and the events come from TimeWindowActuator.
 */
 
 #include "pico/stdlib.h"
 #include "Alarm.hpp"
 
-Alarm::Alarm(int qLength)
+AlarmMatcher::AlarmMatcher()
 {
-    // Create alarm event queue
-    outQueue = xQueueCreate(qLength, sizeof(AlarmEvent));
-
     // init default time (example)
-    config.timeBeg = {2025, 1, 1, 7, 0, 0};
-    config.CalcAlarmTimeEnd();
+    for (int i = 0; i < MaxAlarms; i++) {
+        configs[i].timeBeg = {2025, 1, 1, 7, 0, 0};
+        configs[i].CalcAlarmTimeEnd();
+        heapPos[i] = -1;
+    }
 }
 
-void Alarm::ProcessCurrentTime(const DateTime& time)
+bool AlarmMatcher::IsActive(int64_t now, int& index)
 {
-    if (config.enabled)
-    {
-        bool isAlarmNow = IsAlarmTime(time);
+    // The table holds the fire times after the previous call;
+    // if the clock was set back or moved by more than a day
+    // it is cheaper to rebuild it than to walk through the days
+    if (!synced || now < lastTime || now - lastTime > DateTime::SecondsPerDay) {
+        Rebuild(now);
+    }
+    lastTime = now;
+
+    // In most ticks nothing is due, and only the head is compared
+    while (heapSize > 0 && heap[0].fireAt <= now) {
+        uint8_t fired = heap[0].index;
+        int64_t fireAt = heap[0].fireAt;
+        int64_t windowEnd = fireAt + configs[fired].duration;
+
+        HeapUpdate(fired, NextFireTime(configs[fired], fireAt + 1));
+
+        if (windowEnd <= now) {
+            continue; // The window is already over
+        }
+
+        if (windowEnd > ringingUntil) {
+            ringingUntil = windowEnd;
+        }
+        index = fired;
+    }
+
+    return now < ringingUntil;
+}
+
+DateTime AlarmMatcher::NextChange(int64_t now) const
+{
+    if (!synced) {
+        // The table will be built on the next call
+        return DateTime::FromSeconds(now + 1);
+    }
+
+    int64_t next = DateTime::Never;
+    if (heapSize > 0) {
+        next = heap[0].fireAt;
+    }
+    if (ringingUntil > lastTime && ringingUntil < next) {
+        next = ringingUntil;
+    }
+
+    return DateTime::FromSeconds(next);
+}
+
+int AlarmMatcher::CountMissed(int64_t from, int64_t to, int& index) const
+{
+    const int64_t SecondsPerWeek = 7 * DateTime::SecondsPerDay;
+    int count = 0;
+    int64_t latest = from;
+
+    for (int i = 0; i < MaxAlarms; i++) {
+        const AlarmConfig& config = configs[i];
+        if (!IsScheduled(config)) {
+            continue;
+        }
+
+        // The fire times in (from, last] are the missed windows
+        int64_t last = to - config.duration;
+        if (last <= from) {
+            continue;
+        }
+
+        // Each weekday repeats once a week, count them separately
+        int64_t first = NextFireTime(config, from + 1);
+        for (int day = 0; day < 7 && first <= last; day++) {
+            if (config.IsActiveOn(DateTime::FromSeconds(first).DayOfWeek())) {
+                int64_t weeks = (last - first) / SecondsPerWeek;
+                count += static_cast<int>(weeks + 1);
+
+                int64_t lastFire = first + weeks * SecondsPerWeek;
+                if (lastFire > latest) {
+                    latest = lastFire;
+                    index = i;
+                }
+            }
+            first += DateTime::SecondsPerDay;
+        }
+    }
+
+    return count;
+}
+
+void AlarmMatcher::SetConfig(int index, const AlarmConfig& newConfig)
+{
+    configs[index].CopyDateFrom(newConfig);
+    if (synced && IsScheduled(configs[index])) {
+        int64_t fireAt = NextFireTime(configs[index], lastTime + 1);
+        if (heapPos[index] < 0) {
+            HeapPush(index, fireAt);
+        } else {
+            HeapUpdate(index, fireAt);
+        }
+    } else if (heapPos[index] >= 0) {
+        HeapRemove(index);
+    }
+}
+
+void AlarmMatcher::SetConfigs(const AlarmConfig* newConfigs, int count)
+{
+    for (int i = 0; i < count; i++) {
+        configs[i].CopyDateFrom(newConfigs[i]);
+    }
+    synced = false; // Rebuild on the next tick
+}
+
+bool AlarmMatcher::GetNextConfig(AlarmConfig& outConfig) const
+{
+    if (synced) {
+        if (heapSize == 0) {
+            return false;
+        }
+        outConfig.CopyDateFrom(configs[heap[0].index]);
+        return true;
+    }
 
-        if (isAlarmNow && !state.ringing)
-        {
-            state.ringing = true;
-            AlarmEvent evt{AlarmEventType::AlarmOn, state, config};
-            xQueueSend(outQueue, &evt, 0);
+    // The table is not built yet, pick the earliest time of day
+    const AlarmConfig* first = nullptr;
+    for (int i = 0; i < MaxAlarms; i++) {
+        if (IsScheduled(configs[i]) &&
+            (first == nullptr || configs[i].timeBeg.SecondOfDay() < first->timeBeg.SecondOfDay())) {
+            first = &configs[i];
         }
-        else if (!isAlarmNow && state.ringing)
-        {
-            state.ringing = false;
-            AlarmEvent evt{AlarmEventType::AlarmOff, state, config};
-            xQueueSend(outQueue, &evt, 0);
+    }
+
+    if (first == nullptr) {
+        return false;
+    }
+    outConfig.CopyDateFrom(*first);
+    return true;
+}
+
+void AlarmMatcher::Rebuild(int64_t now)
+{
+    heapSize = 0;
+    for (int i = 0; i < MaxAlarms; i++) {
+        heapPos[i] = -1;
+    }
+
+    // The windows which are in progress fire right away,
+    // so an alarm started before the time change still rings to its end
+    ringingUntil = now;
+    for (int i = 0; i < MaxAlarms; i++) {
+        if (IsScheduled(configs[i])) {
+            HeapPush(i, NextFireTime(configs[i], now - configs[i].duration + 1));
         }
     }
+
+    synced = true;
 }
 
+bool AlarmMatcher::IsScheduled(const AlarmConfig& config) const
+{
+    return config.enabled && config.duration > 0 && config.weekdays != 0;
+}
 
-QueueHandle_t Alarm::GetEventQueue() const { return outQueue; }
+int64_t AlarmMatcher::NextFireTime(const AlarmConfig& config, int64_t from) const
+{
+    // First occurrence of the time of day at or after "from"
+    DateTime candidate = DateTime::FromSeconds(from);
+    candidate.CopyTimeFrom(config.timeBeg);
+    if (candidate.seconds < from) {
+        candidate.IncrementDays();
+    }
+
+    // Skip the days which are not in the weekday mask
+    for (int i = 0; i < 7 && !config.IsActiveOn(candidate.DayOfWeek()); i++) {
+        candidate.IncrementDays();
+    }
 
-bool Alarm::IsAlarmTime(const DateTime& currentTime) const 
+    return candidate.seconds;
+}
+
+void AlarmMatcher::HeapPush(uint8_t index, int64_t fireAt)
 {
-    return
-        config.timeBeg.hour <= currentTime.hour && currentTime.hour <= config.timeEnd.hour &&
-        config.timeBeg.minute <= currentTime.minute && currentTime.minute <= config.timeEnd.minute &&
-        config.timeBeg.second <= currentTime.second && currentTime.second < config.timeEnd.second;
+    int pos = heapSize++;
+    heap[pos] = {fireAt, index};
+    heapPos[index] = pos;
+    SiftUp(pos);
+}
+
+void AlarmMatcher::HeapRemove(uint8_t index)
+{
+    int pos = heapPos[index];
+    int last = --heapSize;
+    heapPos[index] = -1;
+
+    if (pos == last) {
+        return;
+    }
+
+    // Move the last slot into the hole and restore the order
+    uint8_t moved = heap[last].index;
+    heap[pos] = heap[last];
+    heapPos[moved] = pos;
+    SiftUp(pos);
+    SiftDown(heapPos[moved]);
+}
+
+void AlarmMatcher::HeapUpdate(uint8_t index, int64_t fireAt)
+{
+    int pos = heapPos[index];
+    int64_t previous = heap[pos].fireAt;
+    heap[pos].fireAt = fireAt;
+
+    if (fireAt < previous) {
+        SiftUp(pos);
+    } else {
+        SiftDown(pos);
+    }
+}
+
+void AlarmMatcher::HeapSwap(int a, int b)
+{
+    FireSlot tmp = heap[a];
+    heap[a] = heap[b];
+    heap[b] = tmp;
+    heapPos[heap[a].index] = a;
+    heapPos[heap[b].index] = b;
+}
+
+void AlarmMatcher::SiftUp(int pos)
+{
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (heap[parent].fireAt <= heap[pos].fireAt) {
+            break;
+        }
+        HeapSwap(parent, pos);
+        pos = parent;
+    }
+}
+
+void AlarmMatcher::SiftDown(int pos)
+{
+    while (true) {
+        int smallest = pos;
+        int left = 2 * pos + 1;
+        int right = left + 1;
+
+        if (left < heapSize && heap[left].fireAt < heap[smallest].fireAt) {
+            smallest = left;
+        }
+        if (right < heapSize && heap[right].fireAt < heap[smallest].fireAt) {
+            smallest = right;
+        }
+        if (smallest == pos) {
+            break;
+        }
+
+        HeapSwap(pos, smallest);
+        pos = smallest;
+    }
 }
@@ -1,5 +1,11 @@
 /*
   * Alarm Class
+    * Holds up to MaxAlarms daily alarms, each with its own time,
+    * duration, enable flag and weekday mask.
+    * The enabled alarms are kept in a binary min-heap ordered by
+    * their next fire time, so a tick only compares the current time
+    * with the head of the heap and a reconfiguration costs O(log n).
+    * The state and the events come from TimeWindowActuator.
 */
 
 #pragma once
@@ -9,20 +15,16 @@
 #include "task.h"
 #include <stdint.h>
 #include "DateTime.h"
-
-struct AlarmState {
-    bool ringing = false; // True if the alarm is currently ringing
-
-    void CopyFrom(const AlarmState& other) {
-        ringing = other.ringing;
-    }
-};
+#include "TimeWindowActuator.hpp"
 
 struct AlarmConfig {
+    static constexpr uint8_t AllDays = 0x7F;
+
     DateTime timeBeg; // Start time of the alarm
     DateTime timeEnd; // End time of the alarm
     int duration = 10; // Duration of the alarm in seconds
     bool enabled = false; // True if the alarm is set and active
+    uint8_t weekdays = AllDays; // Bit 0 is Monday, bit 6 is Sunday
 
     void CalcAlarmTimeEnd()
     {
@@ -31,55 +33,88 @@ struct AlarmConfig {
         timeEnd.AddSeconds(duration);
     }
 
+    bool IsActiveOn(int dayOfWeek) const {
+        return (weekdays & (1 << dayOfWeek)) != 0;
+    }
+
     void CopyDateFrom(const AlarmConfig& other) {
         timeBeg.CopyTimeFrom(other.timeBeg);
         duration = other.duration;
         enabled = other.enabled;
+        weekdays = other.weekdays;
         CalcAlarmTimeEnd();
     }
 };
 
-enum class AlarmEventType {
-    AlarmOn,
-    AlarmOff,
-    Reconfigured,
-};
+// Window matching of the alarms
+class AlarmMatcher {
+public:
+    static constexpr int MaxAlarms = 32;
+    static constexpr int MaxConfigs = MaxAlarms;
 
-struct AlarmEvent {
-    AlarmEventType type;
-    AlarmState state;   // Current state of the alarm
-    AlarmConfig config; // Current configuration of the alarm
-};
+    AlarmMatcher();
 
-class Alarm {
-public:
-    Alarm(int qLength);
+    // Advance to the given time; true if any alarm window is open,
+    // index is set to the alarm which has fired last
+    bool IsActive(int64_t now, int& index);
 
-    void ProcessCurrentTime(const DateTime& time);
+    // Amount of the alarm windows which opened after "from" and closed
+    // before "to"; index is set to the one which opened last.
+    // Costs up to 7 steps per alarm, no matter how long the jump is
+    int CountMissed(int64_t from, int64_t to, int& index) const;
 
-    void SetAlarmConfig(const AlarmConfig& newConfig) {
-        config.CopyDateFrom(newConfig);
-        AlarmEvent evt{AlarmEventType::Reconfigured, state, config};
-        xQueueSend(outQueue, &evt, 0);
-    }
+    // The first moment after the last processed time when
+    // the alarm may switch, DateTime::Never if it never does
+    DateTime NextChange(int64_t now) const;
 
-    void GetAlarmConfig(AlarmConfig& outConfig) const {
-        outConfig.CopyDateFrom(config);
-    }
+    void SetConfig(int index, const AlarmConfig& newConfig);
+    void SetConfigs(const AlarmConfig* newConfigs, int count);
 
-    void GetAlarmState(AlarmState& outState) const {
-        outState.CopyFrom(state);
+    void GetConfig(int index, AlarmConfig& outConfig) const {
+        outConfig.CopyDateFrom(configs[index]);
     }
 
-    QueueHandle_t GetEventQueue() const;
+    bool GetNextConfig(AlarmConfig& outConfig) const;
 
 private:
-    static void TaskLoop(void* param);
-
-    bool IsAlarmTime(const DateTime& currentTime) const;
+    // Entry of the next fire table
+    struct FireSlot {
+        int64_t fireAt; // Seconds since epoch
+        uint8_t index;  // Index in the configs
+    };
+
+    void Rebuild(int64_t now);
+    int64_t NextFireTime(const AlarmConfig& config, int64_t from) const;
+    bool IsScheduled(const AlarmConfig& config) const;
+
+    // Binary heap operations, all of them keep heapPos in sync
+    void HeapPush(uint8_t index, int64_t fireAt);
+    void HeapRemove(uint8_t index);
+    void HeapUpdate(uint8_t index, int64_t fireAt);
+    void HeapSwap(int a, int b);
+    void SiftUp(int pos);
+    void SiftDown(int pos);
+
+    AlarmConfig configs[MaxAlarms];
+
+    FireSlot heap[MaxAlarms];
+    int8_t heapPos[MaxAlarms]; // Position in the heap, -1 if not scheduled
+    int heapSize = 0;
+
+    int64_t lastTime = 0;       // The time of the previous tick
+    bool synced = false;        // False until the table is built for the current time
+    int64_t ringingUntil = 0;   // End of the latest started alarm window
+};
 
-    AlarmState state;
-    AlarmConfig config;
+struct AlarmPolicy {
+    using Config = AlarmConfig;
+    using Matcher = AlarmMatcher;
 
-    QueueHandle_t outQueue;
+    static void SetOutput(GPIOControl& gpio, bool on);
+    static void PlayFeedback(PiezoSound& sound, ActuatorEventType type);
+    static void ShowEvent(MainScreen& mainScreen, const ActuatorEvent<AlarmConfig>& evt);
 };
+
+using Alarm = TimeWindowActuator<AlarmPolicy>;
+using AlarmState = ActuatorState;
+using AlarmEvent = Alarm::Event;
@@ -2,18 +2,34 @@
   * Clock Class
     * This class manages the system clock, including current time, alarm functionality,
     * and periodic ticking.
-    * It uses FreeRTOS for task management and event handling.
-    * The clock ticks every second and can be paused or resumed.
+    * The wall time lives in the RP2350 always-on (AON) timer, so reading it
+    * is a register read and it keeps counting regardless of the scheduler load.
+    * The clock ticks every second from the AON timer alarm and can be paused or resumed.
+    * The tick interval can be made longer or the ticks turned off; the same
+    * alarm then wakes the system only at the requested transition time.
     * It also supports setting and getting the current time and alarm time.
     * The clock emits events to a queue for external handling.
     * The clock can be used in applications that require timekeeping and alarm functionality.
     * It is designed to be thread-safe and can be used in a FreeRTOS environment
 */
 
+#include <time.h>
+
 #include "pico/stdlib.h"
+#include "pico/aon_timer.h"
 
 #include "Clock.hpp"
 
+Clock* Clock::instance = nullptr;
+
+static struct timespec ToTimespec(const DateTime& time)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)time.seconds;
+    ts.tv_nsec = 0;
+    return ts;
+}
+
 Clock::Clock(int qLength){
     // Create clock event queue
     outQueue = xQueueCreate(qLength, sizeof(ClockEvent));
@@ -23,31 +39,192 @@ Clock::Clock(int qLength){
 }
 
 void Clock::Start() {
-    xTaskCreate(TaskLoop, "ClockTickTask", 1024, this, 1, nullptr);
+    instance = this;
+
+    struct timespec ts = ToTimespec(currentTime);
+    aon_timer_start(&ts);
+    SetDriftBase(ts);
+    started = true;
+
+    ArmNextTick();
+}
+
+// The drift is measured against the crystal driven system timer
+// from the moment the AON timer got its time
+void Clock::SetDriftBase(const struct timespec& ts) {
+    driftBaseUs = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 - (int64_t)time_us_64();
 }
 
-void Clock::TaskLoop(void* param) {
-    Clock* self = static_cast<Clock*>(param);
-    while (true) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        if (self->running) {
-            self->Tick();
-        }
+void Clock::AlarmHandler() {
+    if (instance != nullptr) {
+        instance->OnAlarm();
     }
 }
 
-void Clock::Tick() {
-    // === Time Incrementation ===
-    currentTime.IncrementSeconds();
+void Clock::OnAlarm() {
+    struct timespec ts;
+    aon_timer_get_time(&ts);
+    int64_t nowMs = (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+
+    // === Statistics ===
+    int64_t latenessMs = nowMs - nextTickMs;
+    if (latenessMs < 0) {
+        latenessMs = 0;
+    }
+    stats.ticks++;
+    stats.lastLatenessUs = (uint32_t)(latenessMs * 1000);
+    if (stats.lastLatenessUs > stats.maxLatenessUs) {
+        stats.maxLatenessUs = stats.lastLatenessUs;
+    }
+    stats.lastTickOffsetUs = (uint32_t)(ts.tv_nsec / 1000);
+    int64_t aonUs = (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    stats.driftUs = (int32_t)(aonUs - (int64_t)time_us_64() - driftBaseUs);
 
     // === Normal Tick Event ===
-    ClockEvent evt{ClockEventType::Tick, currentTime};
+    if (running) {
+        ClockEventType type = nextIsTick ? ClockEventType::Tick : ClockEventType::Transition;
+        ClockEvent evt{type, DateTime::FromSeconds(ts.tv_sec), DateTime()};
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        xQueueSendFromISR(outQueue, &evt, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+
+    ArmNextTick();
+}
+
+void Clock::ArmNextTick() {
+    struct timespec ts;
+    aon_timer_get_time(&ts);
+    int64_t now = ts.tv_sec;
+
+    // Next multiple of the interval after now, even if some ticks were missed
+    int64_t tickAt = DateTime::Never;
+    if (tickInterval > 0) {
+        tickAt = (now / tickInterval + 1) * tickInterval;
+    }
+
+    // A wakeup which is already due is served on the next second
+    int64_t wakeAt = wakeupAt;
+    if (wakeAt <= now) {
+        wakeAt = now + 1;
+    }
+
+    int64_t target = (tickAt <= wakeAt) ? tickAt : wakeAt;
+    if (target == DateTime::Never) {
+        // Nothing to wait for, sleep until reconfigured
+        aon_timer_disable_alarm();
+        return;
+    }
+
+    nextIsTick = (target == tickAt);
+    nextTickMs = target * 1000;
+
+    struct timespec next = ToTimespec(DateTime::FromSeconds(target));
+    aon_timer_enable_alarm(&next, AlarmHandler, false);
+}
+
+void Clock::SetTickInterval(int seconds) {
+    taskENTER_CRITICAL();
+    tickInterval = (seconds > 0) ? seconds : 0;
+    if (started && running) {
+        ArmNextTick();
+    }
+    taskEXIT_CRITICAL();
+}
+
+void Clock::SetWakeupTime(const DateTime& time) {
+    taskENTER_CRITICAL();
+    wakeupAt = time.seconds;
+    if (started && running) {
+        ArmNextTick();
+    }
+    taskEXIT_CRITICAL();
+}
+
+void Clock::RequestReschedule() {
+    DateTime now;
+    GetCurrentTime(now);
+
+    ClockEvent evt{ClockEventType::Reschedule, now, DateTime()};
+    xQueueSend(outQueue, &evt, 0);
+}
+
+void Clock::SendTimeJump(const DateTime& previousTime) {
+    DateTime now;
+    GetCurrentTime(now);
+
+    ClockEvent evt{ClockEventType::TimeJump, now, previousTime};
     xQueueSend(outQueue, &evt, 0);
 }
 
-void Clock::Pause() { running = false; }
-void Clock::Resume() { running = true; }
+DateTime Clock::ReadTime() const {
+    struct timespec ts;
+    aon_timer_get_time(&ts);
+    return DateTime::FromSeconds(ts.tv_sec);
+}
+
+void Clock::Pause() {
+    taskENTER_CRITICAL();
+    if (running && started) {
+        currentTime = ReadTime(); // freeze the time
+    }
+    running = false;
+    taskEXIT_CRITICAL();
+}
+
+void Clock::Resume() {
+    DateTime previousTime;
+    GetCurrentTime(previousTime);
+
+    taskENTER_CRITICAL();
+    if (!running && started) {
+        // Continue from the time the clock was paused at
+        struct timespec ts = ToTimespec(currentTime);
+        aon_timer_set_time(&ts);
+        SetDriftBase(ts);
+    }
+    running = true;
+    bool wasStarted = started;
+    if (started) {
+        ArmNextTick();
+    }
+    taskEXIT_CRITICAL();
+
+    // The schedule saw no ticks while the clock was paused
+    if (wasStarted) {
+        SendTimeJump(previousTime);
+    }
+}
+
+void Clock::SetCurrentTime(const DateTime& newTime) {
+    DateTime previousTime;
+    GetCurrentTime(previousTime);
+
+    taskENTER_CRITICAL();
+    currentTime = newTime;
+    bool wasStarted = started;
+    if (started && running) {
+        struct timespec ts = ToTimespec(newTime);
+        aon_timer_set_time(&ts);
+        SetDriftBase(ts);
+        ArmNextTick();
+    }
+    taskEXIT_CRITICAL();
+
+    // The pending wakeup was calculated for the old time,
+    // and the transitions in between have to be accounted for;
+    // the time set before Start is the initial one, not a jump
+    if (wasStarted) {
+        SendTimeJump(previousTime);
+    }
+}
+
+void Clock::GetCurrentTime(DateTime& outTime) {
+    if (started && running) {
+        outTime.CopyFrom(ReadTime());
+    } else {
+        outTime.CopyFrom(currentTime);
+    }
+}
 
-void Clock::SetCurrentTime(const DateTime& newTime) { currentTime = newTime; }
-void Clock::GetCurrentTime(DateTime& outTime) { outTime.CopyFrom(currentTime); }
 QueueHandle_t Clock::GetEventQueue() const { return outQueue; }
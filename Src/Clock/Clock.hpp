@@ -2,8 +2,11 @@
   * Clock Class
     * This class manages the system clock, including current time, alarm functionality,
     * and periodic ticking.
-    * It uses FreeRTOS for task management and event handling.
-    * The clock ticks every second and can be paused or resumed.
+    * The wall time lives in the RP2350 always-on (AON) timer, so reading it
+    * is a register read and it keeps counting regardless of the scheduler load.
+    * The clock ticks every second from the AON timer alarm and can be paused or resumed.
+    * The tick interval can be made longer or the ticks turned off; the same
+    * alarm then wakes the system only at the requested transition time.
     * It also supports setting and getting the current time and alarm time.
     * The clock emits events to a queue for external handling.
     * The clock can be used in applications that require timekeeping and alarm functionality.
@@ -19,12 +22,25 @@
 #include "DateTime.h"
 
 enum class ClockEventType {
-    Tick,
+    Tick,        // Periodic tick for the display
+    Transition,  // The requested wakeup time has come
+    Reschedule,  // The schedule was changed, the wakeup time has to be recalculated
+    TimeJump,    // The time was set or resumed, the schedule has to catch up
 };
 
 struct ClockEvent {
     ClockEventType type;
     DateTime currentTime;
+    DateTime previousTime; // The time before the jump, TimeJump only
+};
+
+// Timing statistics of the tick alarm
+struct ClockStats {
+    uint32_t ticks = 0;              // Amount of processed ticks
+    uint32_t lastLatenessUs = 0;     // Delay of the last tick after its deadline
+    uint32_t maxLatenessUs = 0;      // Worst delay of a tick after its deadline
+    uint32_t lastTickOffsetUs = 0;   // Offset of the last tick from its whole second
+    int32_t driftUs = 0;             // AON time gained on the system timer since the time was set
 };
 
 class Clock {
@@ -38,16 +54,44 @@ public:
 
     void GetCurrentTime(DateTime& outTime);
 
-    void Start();  // create the task
+    void Start();  // start the AON timer and the tick alarm
+
+    // Period of the Tick events in seconds, aligned to the multiples
+    // of the period (60 gives the minute ticks), 0 turns them off
+    void SetTickInterval(int seconds);
+
+    // Emit a Transition event at the given time; a single
+    // wakeup is kept, every call replaces the previous one
+    void SetWakeupTime(const DateTime& time);
+
+    // Emit a Reschedule event right away
+    void RequestReschedule();
 
     QueueHandle_t GetEventQueue() const;
 
+    void GetStats(ClockStats& outStats) const { outStats = stats; }
+
 private:
-    static void TaskLoop(void* param);
-    void Tick();  // the per-second logic
+    static void AlarmHandler();
+    void OnAlarm();       // the per-second logic
+    void ArmNextTick();   // schedule the alarm at the next tick or wakeup
+    DateTime ReadTime() const;
+    void SendTimeJump(const DateTime& previousTime);
+    void SetDriftBase(const struct timespec& ts);
 
-    DateTime currentTime;
-    bool running = true; // true if the clock is running (ticking)
+    ClockStats stats;
+
+    DateTime currentTime;  // the time before Start() and while paused
+    bool started = false;  // true if the AON timer holds the time
+    bool running = true;   // true if the clock is running (ticking)
+    int64_t nextTickMs = 0;
+    bool nextIsTick = true;              // false if the alarm is armed for the wakeup
+    int tickInterval = 1;                // seconds, 0 if the ticks are off
+    int64_t wakeupAt = DateTime::Never;  // seconds since epoch
+    int64_t driftBaseUs = 0;             // AON time minus system time when the time was set
 
     QueueHandle_t outQueue;
+
+    // The AON timer alarm has a single handler
+    static Clock* instance;
 };
@@ -2,251 +2,184 @@
   * Clock Related Types and Structures
     * This header defines the structures and enums used for managing date and time,
     * clock events, and alarm functionality in a system.
+    * The time is stored as seconds since 1970-01-01 00:00:00,
+    * so comparison and arithmetic are plain integer operations.
+    * The broken-down fields are produced only when they are needed
+    * (formatting and per-field editing) by the civil calendar conversions.
 */
 
 #pragma once
 
-#include "pico/stdlib.h"
+#include <stdint.h>
+
+// Broken-down representation of the DateTime
+struct CivilTime {
+  int year;
+  int month;  // 1-12
+  int day;    // 1-31
+  int hour;   // 0-23
+  int minute; // 0-59
+  int second; // 0-59
+};
 
 struct DateTime {
-  uint16_t year;
-  uint8_t month;
-  uint8_t day;
-  uint8_t hour;
-  uint8_t minute;
-  uint8_t second;
+  static constexpr int64_t SecondsPerMinute = 60;
+  static constexpr int64_t SecondsPerHour = 60 * SecondsPerMinute;
+  static constexpr int64_t SecondsPerDay = 24 * SecondsPerHour;
 
-  void CopyFrom(const DateTime& other) {
-    year = other.year;
-    month = other.month;
-    day = other.day;
-    hour = other.hour;
-    minute = other.minute;
-    second = other.second;
-  }
+  // The moment which never comes, used for "no transition scheduled"
+  static constexpr int64_t Never = INT64_MAX;
 
-  void CopyDateFrom(const DateTime& other) {
-    year = other.year;
-    month = other.month;
-    day = other.day;
-  }
+  int64_t seconds; // Seconds since 1970-01-01 00:00:00
 
-  void CopyTimeFrom(const DateTime& other) {
-    hour = other.hour;
-    minute = other.minute;
-    second = other.second;
-  }
+  DateTime() = default;
 
-  void AddSeconds(int seconds, bool propagate = true)
-  {
-    // We do not add negative seconds
-    // If seconds is negative, we do nothing
-    if(seconds < 0)
-    {
-        return;
-    }
+  constexpr DateTime(int year, int month, int day, int hour, int minute, int second)
+    : seconds(DaysFromCivil(year, month, day) * SecondsPerDay +
+              hour * SecondsPerHour + minute * SecondsPerMinute + second) {}
 
-    // If seconds >= 60, limit it to 59
-    if (seconds >= 60)
-    {
-        seconds = 59;
-    }
-    
-    second += seconds;
-    if (second >= 60)
-    {
-        second -= 60;
-        IncrementMinutes(propagate);
-    }
+  static constexpr DateTime FromSeconds(int64_t seconds) {
+    DateTime result{};
+    result.seconds = seconds;
+    return result;
   }
 
-  void IncrementSeconds(bool propagate = true)
-  {
-    second++;
-
-    if (second >= 60)
-    {
-        second = 0;
-
-        // If propagate is true, 
-        // we increment the minute
-        if (propagate)
-        {
-          IncrementMinutes(propagate);
-        }
-    }
+  static constexpr DateTime FromCivil(const CivilTime& civil) {
+    return DateTime(civil.year, civil.month, civil.day,
+                    civil.hour, civil.minute, civil.second);
   }
 
-  void IncrementMinutes(bool propagate = true)
-  {
-    minute++;
+  constexpr CivilTime ToCivil() const {
+    int64_t days = Days();
+    int64_t sod = SecondOfDay();
 
-    if (minute >= 60)
-    {
-        minute = 0;
-
-        // If propagate is true, 
-        // we increment the hour
-        if (propagate)
-        {
-          IncrementHours(propagate);
-        }
-    }
+    CivilTime civil = CivilFromDays(days);
+    civil.hour = static_cast<int>(sod / SecondsPerHour);
+    civil.minute = static_cast<int>(sod / SecondsPerMinute % 60);
+    civil.second = static_cast<int>(sod % 60);
+    return civil;
   }
 
-  void IncrementHours(bool propagate = true)
-  {
-    hour++;
-    
-    if (hour >= 24)
-    {
-        hour = 0;
-
-        // If propagate is true, 
-        // we increment the day
-        if (propagate)
-        {
-          IncrementDays();
-        }
-    }
+  // Days since 1970-01-01
+  constexpr int64_t Days() const {
+    return FloorDiv(seconds, SecondsPerDay);
   }
 
-  void IncrementDays()
-  {
-    day++;
-
-    int maxDay = DateTime::DaysInMonth(month, year);
-    if (day > maxDay)
-    {
-        day = 1;
-        IncrementMonths();
-    }
+  // Seconds since the midnight of the same day
+  constexpr int64_t SecondOfDay() const {
+    return seconds - Days() * SecondsPerDay;
   }
 
-  void IncrementMonths()
-  {
-    month++;
-
-    if (month > 12)
-    {
-        month = 1;
-        IncrementYears();
-    }
+  // Day of the week: 0 is Monday, 6 is Sunday
+  // (1970-01-01 was Thursday)
+  constexpr int DayOfWeek() const {
+    return static_cast<int>(Days() + 3 - FloorDiv(Days() + 3, 7) * 7);
   }
 
-  void IncrementYears()
-  {
-    year++;
-    day = DateTime::DaysInMonth(month, year);
-  }
-  
-  void DecrementSeconds(bool propagate = true)
-  {
-    if (second > 0)
-    {
-        second--;
-    }
-    else
-    {
-        second = 59;
-
-        // If propagate is true,
-        // we decrement the minute
-        if (propagate)
-        {
-          DecrementMinutes(propagate);
-        }
-    }
-  }
+  constexpr bool operator==(const DateTime& other) const { return seconds == other.seconds; }
+  constexpr bool operator!=(const DateTime& other) const { return seconds != other.seconds; }
+  constexpr bool operator<(const DateTime& other) const { return seconds < other.seconds; }
+  constexpr bool operator<=(const DateTime& other) const { return seconds <= other.seconds; }
+  constexpr bool operator>(const DateTime& other) const { return seconds > other.seconds; }
+  constexpr bool operator>=(const DateTime& other) const { return seconds >= other.seconds; }
 
-  void DecrementMinutes(bool propagate = true)
-  {
-    if (minute > 0)
-    {
-        minute--;
-    }
-    else
-    {
-        minute = 59;
-
-        // If propagate is true,
-        // we decrement the hour
-        if (propagate)
-        {
-          DecrementHours(propagate);
-        }
-    }
-  }
+  constexpr DateTime operator+(int64_t delta) const { return FromSeconds(seconds + delta); }
+  constexpr DateTime operator-(int64_t delta) const { return FromSeconds(seconds - delta); }
+  constexpr int64_t operator-(const DateTime& other) const { return seconds - other.seconds; }
 
-  void DecrementHours(bool propagate = true)
-  {
-    if (hour > 0)
-    {
-        hour--;
-    }
-    else
-    {
-        hour = 23;
-
-        // If propagate is true,
-        // we decrement the day
-        if (propagate)
-        {
-          DecrementDays();
-        }
-    }
-  }
-
-  void DecrementDays()
-  {
-    if (day > 1)
-    {
-        day--;
-    }
-    else
-    {
-        DecrementMonths();
-    }
+  void CopyFrom(const DateTime& other) {
+    seconds = other.seconds;
   }
 
-  void DecrementMonths()
-  {
-    if (month > 1)
-    {
-        month--;
-    }
-    else
-    {
-        month = 12;
-        year--;
-    }
-
-    day = DateTime::DaysInMonth(month, year);
+  // Take the date from other, keep the time of day
+  void CopyDateFrom(const DateTime& other) {
+    seconds = other.Days() * SecondsPerDay + SecondOfDay();
   }
 
-  void DecrementYears()
-  {
-    if (year > 0)
-    {
-        year--;
-    }
-    else
-    {
-        year = 0; // Prevent underflow
-    }
-    
-    day = DateTime::DaysInMonth(month, year);
+  // Take the time of day from other, keep the date
+  void CopyTimeFrom(const DateTime& other) {
+    seconds = Days() * SecondsPerDay + other.SecondOfDay();
+  }
+
+  // Add or subtract any amount of seconds
+  void AddSeconds(int64_t delta) {
+    seconds += delta;
+  }
+
+  // The propagate flag tells whether the overflow goes
+  // to the next field (true) or the field wraps around (false)
+  void IncrementSeconds(bool propagate = true) { StepSeconds(1, propagate); }
+  void IncrementMinutes(bool propagate = true) { StepMinutes(1, propagate); }
+  void IncrementHours(bool propagate = true) { StepHours(1, propagate); }
+  void IncrementDays() { seconds += SecondsPerDay; }
+  void IncrementMonths() { AddMonths(1); }
+  void IncrementYears() { AddMonths(12); }
+
+  void DecrementSeconds(bool propagate = true) { StepSeconds(-1, propagate); }
+  void DecrementMinutes(bool propagate = true) { StepMinutes(-1, propagate); }
+  void DecrementHours(bool propagate = true) { StepHours(-1, propagate); }
+  void DecrementDays() { seconds -= SecondsPerDay; }
+  void DecrementMonths() { AddMonths(-1); }
+  void DecrementYears() { AddMonths(-12); }
+
+  // Move a field by any amount of its units, backwards if negative
+  void StepSeconds(int delta, bool propagate = true) { StepField(delta, SecondsPerMinute, propagate); }
+  void StepMinutes(int delta, bool propagate = true) { StepField(delta * SecondsPerMinute, SecondsPerHour, propagate); }
+  void StepHours(int delta, bool propagate = true) { StepField(delta * SecondsPerHour, SecondsPerDay, propagate); }
+
+  // Move by whole months keeping the time of day,
+  // the day is clamped to the length of the target month
+  void AddMonths(int delta) {
+    CivilTime civil = ToCivil();
+    int64_t monthIndex = static_cast<int64_t>(civil.year) * 12 + (civil.month - 1) + delta;
+    civil.year = static_cast<int>(FloorDiv(monthIndex, 12));
+    civil.month = static_cast<int>(monthIndex - static_cast<int64_t>(civil.year) * 12) + 1;
+
+    int maxDay = DaysInMonth(civil.month, civil.year);
+    if (civil.day > maxDay) {
+      civil.day = maxDay;
+    }
+
+    seconds = FromCivil(civil).seconds;
+  }
+
+  // Number of days since 1970-01-01 for the given civil date
+  // (proleptic Gregorian calendar, H. Hinnant's algorithm)
+  static constexpr int64_t DaysFromCivil(int year, int month, int day) {
+    int64_t y = static_cast<int64_t>(year) - (month <= 2 ? 1 : 0);
+    int64_t era = FloorDiv(y, 400);
+    int64_t yoe = y - era * 400;                                       // [0, 399]
+    int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1; // [0, 365]
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;              // [0, 146096]
+    return era * 146097 + doe - 719468;
+  }
+
+  // Civil date for the given number of days since 1970-01-01,
+  // the time of day fields are left zero
+  static constexpr CivilTime CivilFromDays(int64_t days) {
+    days += 719468;
+    int64_t era = FloorDiv(days, 146097);
+    int64_t doe = days - era * 146097;                                  // [0, 146096]
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; // [0, 399]
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);              // [0, 365]
+    int64_t mp = (5 * doy + 2) / 153;                                   // [0, 11]
+    int64_t day = doy - (153 * mp + 2) / 5 + 1;                         // [1, 31]
+    int64_t month = mp < 10 ? mp + 3 : mp - 9;                          // [1, 12]
+    int64_t year = yoe + era * 400 + (month <= 2 ? 1 : 0);
+
+    CivilTime civil{};
+    civil.year = static_cast<int>(year);
+    civil.month = static_cast<int>(month);
+    civil.day = static_cast<int>(day);
+    return civil;
   }
 
-  private:
-
   // Helper function to get the number of days in a month
   // considering leap years for February
-  // Returns the number of days in the specified month of the specified year
   // month: 1-12 (January to December)
   // year: any valid year (e.g., 2023)
   // Returns: number of days in the month
-  static int DaysInMonth(int month, int year) {
+  static constexpr int DaysInMonth(int month, int year) {
     switch (month) {
       case 2: return IsLeapYear(year) ? 29 : 28;
       case 4: case 6: case 9: case 11: return 30;
@@ -257,7 +190,34 @@ struct DateTime {
   // Helper function to check if a year is a leap year
   // A year is a leap year if it is divisible by 4,
   // except for end-of-century years, which must be divisible by 400.
-  static bool IsLeapYear(int year) {
+  static constexpr bool IsLeapYear(int year) {
     return (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0));
   }
+
+  // Division rounding towards negative infinity,
+  // so the dates before the epoch are handled the same way
+  static constexpr int64_t FloorDiv(int64_t a, int64_t b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+  }
+
+  private:
+
+  // Move a field by step seconds; without propagation the field
+  // wraps around within its period (the unit of the next field)
+  void StepField(int64_t step, int64_t period, bool propagate) {
+    if (propagate) {
+      seconds += step;
+      return;
+    }
+
+    int64_t base = FloorDiv(seconds, period) * period;
+    int64_t offset = seconds - base + step;
+    offset = ((offset % period) + period) % period;
+    seconds = base + offset;
+  }
 };
+
+static_assert(DateTime::DaysFromCivil(1970, 1, 1) == 0, "Epoch must be 1970-01-01");
+static_assert(DateTime::DaysFromCivil(2000, 3, 1) == 11017, "Civil date conversion is broken");
+static_assert(DateTime::CivilFromDays(11017).month == 3, "Civil date conversion is broken");
+static_assert(DateTime(2025, 6, 19, 0, 0, 0).DayOfWeek() == 3, "Day of week is broken");
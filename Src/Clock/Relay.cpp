@@ -1,46 +1,148 @@
 /*
   * Relay Class
+    * Holds up to MaxWindows daily windows with weekday masks.
+    * The windows are merged into a minute-of-week bitmap, so any
+    * overlap or midnight crossing is handled by the bitmap itself
+    * and the relay state at a tick is a single bit test.
+    * The configuration edited from the menu is the first window.
+    * In the thermostat mode the relay follows the thermostat demand,
+    * and the windows, if used at all, only gate it by the time of day.
+    * The state and the events come from TimeWindowActuator.
 */
 
 #include "pico/stdlib.h"
 #include "Relay.hpp"
 
-Relay::Relay(int qLength)
+RelayWindow RelayConfig::ToWindow() const
 {
-    // Create relay event queue
-    outQueue = xQueueCreate(qLength, sizeof(RelayEvent));
+    RelayWindow window;
+    window.begMinute = static_cast<uint16_t>(timeBeg.SecondOfDay() / DateTime::SecondsPerMinute);
+    window.endMinute = static_cast<uint16_t>(timeEnd.SecondOfDay() / DateTime::SecondsPerMinute);
+    window.weekdays = weekdays;
+    return window;
+}
+
+void RelayConfig::FromWindow(const RelayWindow& window)
+{
+    // 24:00 becomes the midnight of the same time of day
+    timeBeg.CopyTimeFrom(DateTime::FromSeconds(window.begMinute * DateTime::SecondsPerMinute));
+    timeEnd.CopyTimeFrom(DateTime::FromSeconds(window.endMinute * DateTime::SecondsPerMinute));
+    weekdays = window.weekdays;
+}
 
+RelayMatcher::RelayMatcher()
+{
     // init default time (example)
-    config.timeBeg = {2025, 1, 1, 7, 0, 0};
-    config.timeEnd = {2025, 1, 1, 19, 0, 0};
+    for (int i = 0; i < MaxWindows; i++) {
+        configs[i].timeBeg = {2025, 1, 1, 7, 0, 0};
+        configs[i].timeEnd = {2025, 1, 1, 19, 0, 0};
+    }
+    RebuildSchedule();
 }
 
-void Relay::ProcessCurrentTime(const DateTime& time)
+bool RelayMatcher::IsActive(int64_t now, int& index)
 {
-    if (config.enabled)
-    {
-        bool isRelayNow = IsRelayTime(time);
+    (void)index;
+    bool wanted = Wanted(now);
 
-        if (isRelayNow && !state.ringing)
-        {
-            state.ringing = true;
-            RelayEvent evt{RelayEventType::RelayOn, state, config};
-            xQueueSend(outQueue, &evt, 0);
-        }
-        else if (!isRelayNow && state.ringing)
-        {
-            state.ringing = false;
-            RelayEvent evt{RelayEventType::RelayOff, state, config};
-            xQueueSend(outQueue, &evt, 0);
-        }
+    if (wanted != output && HoldRemaining(now) == 0) {
+        output = wanted;
+        switched = true;
+        switchedAt = now;
+    }
+    return output;
+}
+
+DateTime RelayMatcher::NextChange(int64_t now) const
+{
+    DateTime next = DateTime::FromSeconds(DateTime::Never);
+    if (!thermostat || gated) {
+        next = schedule.NextChange(DateTime::FromSeconds(now));
+    }
+
+    // A switch held back is made when the hold ends
+    int64_t hold = HoldRemaining(now);
+    if (hold > 0 && Wanted(now) != output && now + hold < next.seconds) {
+        next = DateTime::FromSeconds(now + hold);
     }
+    return next;
 }
 
-QueueHandle_t Relay::GetEventQueue() const { return outQueue; }
+int64_t RelayMatcher::HoldRemaining(int64_t now) const
+{
+    if (!thermostat || !switched) {
+        return 0;
+    }
 
-bool Relay::IsRelayTime(const DateTime& currentTime) const 
+    // The wall time is what the schedule task has, after a jump back
+    // the hold is taken as over rather than stretched
+    int64_t hold = output ? minOnSeconds : minOffSeconds;
+    int64_t elapsed = now - switchedAt;
+    if (elapsed < 0 || elapsed >= hold) {
+        return 0;
+    }
+    return hold - elapsed;
+}
+
+int RelayMatcher::CountMissed(int64_t from, int64_t to, int& index) const
 {
-    return
-        config.timeBeg.hour <= currentTime.hour && currentTime.hour <= config.timeEnd.hour &&
-        config.timeBeg.minute <= currentTime.minute && currentTime.minute < config.timeEnd.minute ;
+    (void)index;
+    if (thermostat) {
+        return 0; // The windows are not switching cycles of their own
+    }
+
+    DateTime fromTime = DateTime::FromSeconds(from);
+    DateTime toTime = DateTime::FromSeconds(to);
+
+    // Every rise in between is a missed window,
+    // except the last one if it is still open
+    int64_t rises = schedule.CountRises(fromTime, toTime);
+    if (rises > 0 && schedule.IsOn(toTime)) {
+        rises--;
+    }
+
+    return (rises > INT32_MAX) ? INT32_MAX : static_cast<int>(rises);
+}
+
+void RelayMatcher::SetConfig(int index, const RelayConfig& newConfig)
+{
+    configs[index].CopyDateFrom(newConfig);
+    if (index >= windowCount) {
+        windowCount = index + 1;
+    }
+    RebuildSchedule();
+}
+
+void RelayMatcher::SetConfigs(const RelayConfig* newConfigs, int count)
+{
+    for (int i = 0; i < count; i++) {
+        configs[i].CopyDateFrom(newConfigs[i]);
+    }
+    windowCount = count;
+    RebuildSchedule();
+}
+
+bool RelayMatcher::GetNextConfig(RelayConfig& outConfig) const
+{
+    for (int i = 0; i < windowCount; i++) {
+        if (configs[i].enabled) {
+            outConfig.CopyDateFrom(configs[i]);
+            return true;
+        }
+    }
+
+    // Nothing is enabled, show the first window anyway
+    outConfig.CopyDateFrom(configs[0]);
+    return false;
+}
+
+void RelayMatcher::RebuildSchedule()
+{
+    // A few words per window, cheap enough to do on every change
+    schedule.Clear();
+    for (int i = 0; i < windowCount; i++) {
+        if (configs[i].enabled) {
+            schedule.AddWindow(configs[i].ToWindow());
+        }
+    }
 }
@@ -1,5 +1,15 @@
 /*
   * Relay Class
+    * Holds up to MaxWindows daily windows with weekday masks.
+    * The windows are merged into a minute-of-week bitmap, so any
+    * overlap or midnight crossing is handled by the bitmap itself
+    * and the relay state at a tick is a single bit test.
+    * The configuration edited from the menu is the first window.
+    * In the thermostat mode the relay follows the thermostat demand,
+    * and the windows, if used at all, only gate it by the time of day;
+    * the minimum on and off times then hold the output itself, so a
+    * gate edge does not switch the relay before they have passed.
+    * The state and the events come from TimeWindowActuator.
 */
 
 #pragma once
@@ -9,68 +19,116 @@
 #include "task.h"
 #include <stdint.h>
 #include "DateTime.h"
-
-struct RelayState {
-    bool ringing = false; // True if the relay is currently ringing
-
-    void CopyFrom(const RelayState& other) {
-        ringing = other.ringing;
-    }
-};
+#include "RelaySchedule.hpp"
+#include "Thermostat.hpp"
+#include "TimeWindowActuator.hpp"
 
 struct RelayConfig {
     DateTime timeBeg; // Start time of the relay
     DateTime timeEnd; // End time of the relay
     bool enabled = false; // True if the relay is set and active
+    uint8_t weekdays = RelayWindow::AllDays; // Bit 0 is Monday, bit 6 is Sunday
 
     void CopyDateFrom(const RelayConfig& other) {
         timeBeg.CopyTimeFrom(other.timeBeg);
         timeEnd.CopyTimeFrom(other.timeEnd);
         enabled = other.enabled;
+        weekdays = other.weekdays;
     }
-};
 
-enum class RelayEventType {
-    RelayOn,
-    RelayOff,
-    Reconfigured
+    RelayWindow ToWindow() const;
+    void FromWindow(const RelayWindow& window);
 };
 
-struct RelayEvent {
-    RelayEventType type;
-    RelayState state;   // Current state of the relay
-    RelayConfig config; // Current configuration of the relay
-};
-
-class Relay {
+// Window matching of the relay
+class RelayMatcher {
 public:
-    Relay(int qLength);
+    static constexpr int MaxWindows = 16;
+    static constexpr int MaxConfigs = MaxWindows;
+
+    RelayMatcher();
+
+    // True if the relay is on at the given time; the bitmap
+    // does not tell which window it is, index is left as is.
+    // The result is taken as the output, the hold counts from its changes
+    bool IsActive(int64_t now, int& index);
+
+    // The first moment after the given time when the relay may switch
+    // by the time or by the end of a hold, DateTime::Never if it never
+    // does; the thermostat demand changes come with the temperature
+    // readings instead
+    DateTime NextChange(int64_t now) const;
+
+    // Switch between the schedule and the thermostat mode
+    void SetThermostatMode(const ThermostatConfig& config) {
+        thermostat = config.enabled;
+        gated = config.gated;
+        minOnSeconds = config.minOnSeconds;
+        minOffSeconds = config.minOffSeconds;
+    }
 
-    void ProcessCurrentTime(const DateTime& time);
+    // The thermostat decision, taken on the temperature readings
+    void SetDemand(bool on) { demand = on; }
 
-    void SetRelayConfig(const RelayConfig& newConfig) {
-        config.CopyDateFrom(newConfig);
-        RelayEvent evt{RelayEventType::Reconfigured, state, config};
-        xQueueSend(outQueue, &evt, 0);
-    }
+    // Amount of the relay windows which opened after "from" and closed
+    // before "to"; the bitmap does not tell which ones, index is left as is
+    int CountMissed(int64_t from, int64_t to, int& index) const;
 
-    void GetRelayConfig(RelayConfig& outConfig) const {
-        outConfig.CopyDateFrom(config);
-    }
+    // A window past the last one extends the list
+    void SetConfig(int index, const RelayConfig& newConfig);
 
-    void GetRelayState(RelayState& outState) const {
-        outState.CopyFrom(state);
+    // Replace all the windows
+    void SetConfigs(const RelayConfig* newConfigs, int count);
+
+    void GetConfig(int index, RelayConfig& outConfig) const {
+        outConfig.CopyDateFrom(configs[index]);
     }
 
-    QueueHandle_t GetEventQueue() const;
+    // The first enabled window
+    bool GetNextConfig(RelayConfig& outConfig) const;
+
+    int GetWindowCount() const { return windowCount; }
+
+    const RelaySchedule& GetSchedule() const { return schedule; }
 
 private:
-    static void TaskLoop(void* param);
+    void RebuildSchedule();
+
+    // The output the windows and the demand ask for
+    bool Wanted(int64_t now) const {
+        if (!thermostat) {
+            return schedule.IsOn(DateTime::FromSeconds(now));
+        }
+        return demand && (!gated || schedule.IsOn(DateTime::FromSeconds(now)));
+    }
+
+    // Seconds the output has to keep its state, 0 in the schedule mode
+    int64_t HoldRemaining(int64_t now) const;
 
-    bool IsRelayTime(const DateTime& currentTime) const;
+    RelayConfig configs[MaxWindows];
+    int windowCount = 1;
+    RelaySchedule schedule;
 
-    RelayConfig config;
-    RelayState state;
+    bool thermostat = false;     // The thermostat mode is on
+    bool gated = false;          // The windows gate the thermostat
+    bool demand = false;         // The thermostat asks for the relay on
+    uint32_t minOnSeconds = 0;   // Least time the output stays on in the thermostat mode
+    uint32_t minOffSeconds = 0;  // Least time the output stays off in the thermostat mode
 
-    QueueHandle_t outQueue;
+    bool output = false;         // The state given by the last IsActive
+    bool switched = false;       // False until the output changed first
+    int64_t switchedAt = 0;      // When the output changed last
 };
+
+struct RelayPolicy {
+    using Config = RelayConfig;
+    using Matcher = RelayMatcher;
+
+    static void SetOutput(GPIOControl& gpio, bool on);
+    static void PlayFeedback(PiezoSound& sound, ActuatorEventType type);
+    static void ShowEvent(MainScreen& mainScreen, const ActuatorEvent<RelayConfig>& evt);
+};
+
+using Relay = TimeWindowActuator<RelayPolicy>;
+using RelayState = ActuatorState;
+using RelayEvent = Relay::Event;
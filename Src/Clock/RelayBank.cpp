@@ -0,0 +1,85 @@
+/*
+  * RelayBank Class
+    * A bank of up to MaxChannels relay outputs, each channel with its
+    * own weekly schedule. The evaluation computes the minute of the
+    * week once and tests one bit per channel.
+*/
+
+#include "RelayBank.hpp"
+
+RelayBank::RelayBank(int channels, int qLength)
+{
+    if (channels < 0) {
+        channels = 0;
+    }
+    if (channels > MaxChannels) {
+        channels = MaxChannels;
+    }
+
+    channelCount = channels;
+    state.channels = static_cast<uint8_t>(channels);
+
+    // Create the event queue
+    outQueue = xQueueCreate(qLength, sizeof(Event));
+}
+
+void RelayBank::SetWindows(int channel, const RelayWindow* windows, int count)
+{
+    if (channel < 0 || channel >= channelCount) {
+        return;
+    }
+
+    // A few words per window; a copy built aside would cost
+    // the 1260 bytes of the bitmap on the caller's stack
+    taskENTER_CRITICAL();
+    schedules[channel].Clear();
+    for (int i = 0; i < count; i++) {
+        schedules[channel].AddWindow(windows[i]);
+    }
+    taskEXIT_CRITICAL();
+
+    SendEvent(RelayBankEventType::Reconfigured, 0);
+}
+
+uint32_t RelayBank::Evaluate(const DateTime& time) const
+{
+    int minute = RelaySchedule::MinuteOfWeek(time);
+
+    uint32_t mask = 0;
+    for (int i = 0; i < channelCount; i++) {
+        if (schedules[i].IsOn(minute)) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+void RelayBank::ProcessCurrentTime(const DateTime& time)
+{
+    uint32_t mask = Evaluate(time);
+    uint32_t changed = mask ^ state.mask;
+    if (changed == 0) {
+        return;
+    }
+
+    state.mask = mask;
+    SendEvent(RelayBankEventType::Changed, changed);
+}
+
+DateTime RelayBank::NextTransition(const DateTime& time) const
+{
+    DateTime next = DateTime::FromSeconds(DateTime::Never);
+    for (int i = 0; i < channelCount; i++) {
+        DateTime change = schedules[i].NextChange(time);
+        if (change < next) {
+            next = change;
+        }
+    }
+    return next;
+}
+
+void RelayBank::SendEvent(RelayBankEventType type, uint32_t changed)
+{
+    Event evt{type, state, changed};
+    xQueueSend(outQueue, &evt, 0);
+}
@@ -0,0 +1,92 @@
+/*
+  * RelayBank Class
+    * A bank of up to MaxChannels relay outputs, each channel with its
+    * own weekly schedule (a RelaySchedule bitmap, so any amount of
+    * windows per channel). A schedule evaluation gives the target state
+    * of all the channels as one bitmask, bit 0 is channel 0; only a
+    * change of the mask produces an event, which GPIOControl applies
+    * to all the pins of the bank in one masked write.
+    * The bank has the same interface towards ScheduleTask and
+    * ActuatorTask as the alarm and the relay.
+*/
+
+#pragma once
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+#include <stdint.h>
+#include "DateTime.h"
+#include "RelaySchedule.hpp"
+#include "TimeWindowActuator.hpp"
+
+struct RelayBankState {
+    uint32_t mask = 0;    // Channels which are on, bit 0 is channel 0
+    uint8_t channels = 0; // Amount of channels in the bank
+
+    void CopyFrom(const RelayBankState& other) {
+        mask = other.mask;
+        channels = other.channels;
+    }
+};
+
+enum class RelayBankEventType {
+    Changed,      // Some channels switched
+    Reconfigured, // A channel schedule was replaced
+};
+
+struct RelayBankEvent {
+    RelayBankEventType type;
+    RelayBankState state; // The state after the event
+    uint32_t changed;     // Channels which switched, Changed only
+};
+
+class RelayBank {
+public:
+    static constexpr int MaxChannels = 8;
+
+    using Event = RelayBankEvent;
+
+    RelayBank(int channels, int qLength);
+
+    // Replace the schedule of a channel with the given windows
+    void SetWindows(int channel, const RelayWindow* windows, int count);
+
+    // Target state of all the channels at the given time
+    uint32_t Evaluate(const DateTime& time) const;
+
+    void ProcessCurrentTime(const DateTime& time);
+
+    // The bank only follows the schedules, the windows
+    // skipped by a jump are not reported
+    void CatchUp(const DateTime& previousTime, const DateTime& newTime) {
+        (void)previousTime;
+        ProcessCurrentTime(newTime);
+    }
+
+    // The first moment after the given time when
+    // any channel switches, DateTime::Never if none does
+    DateTime NextTransition(const DateTime& time) const;
+
+    int GetChannelCount() const { return channelCount; }
+
+    const RelaySchedule& GetSchedule(int channel) const { return schedules[channel]; }
+
+    void GetState(RelayBankState& outState) const {
+        outState.CopyFrom(state);
+    }
+
+    QueueHandle_t GetEventQueue() const { return outQueue; }
+
+    // Carry out an event on the devices
+    static void Apply(const ActuatorOutputs& outputs, const Event& evt);
+
+private:
+    void SendEvent(RelayBankEventType type, uint32_t changed);
+
+    RelaySchedule schedules[MaxChannels];
+    int channelCount;
+    RelayBankState state;
+
+    QueueHandle_t outQueue;
+};
@@ -0,0 +1,343 @@
+/*
+  * RelaySchedule Class
+    * The weekly relay schedule stored as a bitmap with one bit per
+    * minute of the week (10080 bits, 1260 bytes), bit 0 is Monday 00:00.
+    * Any number of windows and weekday patterns can be merged into it,
+    * and "is the relay on now?" is a single bit test.
+    * The windows are the human-readable form, "Mo-Fr 07:50-08:10";
+    * the conversions between them and the bitmap do not depend on
+    * the Pico SDK or FreeRTOS, so they can be used on the host too.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "RelaySchedule.hpp"
+
+static const char* const DayNames[7] = {"Mo", "Tu", "We", "Th", "Fr", "Sa", "Su"};
+
+static_assert(RelaySchedule::MinutesPerWeek % 32 == 0, "The bitmap must fill whole words");
+
+int RelayWindow::Length() const
+{
+    int length = endMinute - begMinute;
+    if (length < 0) {
+        length += RelaySchedule::MinutesPerDay;
+    }
+    return length;
+}
+
+void RelaySchedule::Clear()
+{
+    memset(bits, 0, sizeof(bits));
+}
+
+void RelaySchedule::AddWindow(const RelayWindow& window)
+{
+    int length = window.Length();
+    if (length == 0) {
+        return;
+    }
+
+    for (int day = 0; day < 7; day++) {
+        if (window.IsActiveOn(day)) {
+            SetRange(day * MinutesPerDay + window.begMinute, length, true);
+        }
+    }
+}
+
+void RelaySchedule::SetRange(int from, int length, bool on)
+{
+    if (length >= MinutesPerWeek) {
+        from = 0;
+        length = MinutesPerWeek;
+    }
+
+    from %= MinutesPerWeek;
+    while (length > 0) {
+        // Fill the range word by word, a window of an hour
+        // touches only two or three words
+        int word = from >> 5;
+        int bit = from & 31;
+        int count = 32 - bit;
+        if (count > length) {
+            count = length;
+        }
+
+        uint32_t mask = (count == 32) ? 0xFFFFFFFFu : (((1u << count) - 1) << bit);
+        if (on) {
+            bits[word] |= mask;
+        } else {
+            bits[word] &= ~mask;
+        }
+
+        length -= count;
+        from += count;
+        if (from == MinutesPerWeek) {
+            from = 0;
+        }
+    }
+}
+
+bool RelaySchedule::IsEmpty() const
+{
+    for (int i = 0; i < WordCount; i++) {
+        if (bits[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int RelaySchedule::MinutesToChange(int minuteOfWeek) const
+{
+    // Look for the first bit after the given minute which differs
+    // from its state, comparing whole words
+    uint32_t fill = IsOn(minuteOfWeek) ? 0xFFFFFFFFu : 0;
+    int start = (minuteOfWeek + 1) % MinutesPerWeek;
+    int firstWord = start >> 5;
+    int firstBit = start & 31;
+
+    for (int n = 0; n <= WordCount; n++) {
+        int word = (firstWord + n) % WordCount;
+        uint32_t diff = bits[word] ^ fill;
+        if (n == 0) {
+            diff &= 0xFFFFFFFFu << firstBit;
+        }
+        if (n == WordCount) {
+            // Back at the first word, only its beginning is left
+            diff &= (1u << firstBit) - 1;
+        }
+
+        if (diff != 0) {
+            int minute = word * 32 + __builtin_ctz(diff);
+            int distance = minute - minuteOfWeek;
+            if (distance <= 0) {
+                distance += MinutesPerWeek;
+            }
+            return distance;
+        }
+    }
+
+    return 0;
+}
+
+int RelaySchedule::CountRises(int from, int length) const
+{
+    if (length > MinutesPerWeek) {
+        length = MinutesPerWeek;
+    }
+
+    int count = 0;
+    from %= MinutesPerWeek;
+    while (length > 0) {
+        int word = from >> 5;
+        int bit = from & 31;
+        int chunk = 32 - bit;
+        if (chunk > length) {
+            chunk = length;
+        }
+
+        // A rise is a set bit after a clear one; the bit before
+        // the first one of the word is the top of the previous word
+        uint32_t previous = bits[(word + WordCount - 1) % WordCount];
+        uint32_t rises = bits[word] & ~((bits[word] << 1) | (previous >> 31));
+
+        uint32_t mask = (chunk == 32) ? 0xFFFFFFFFu : (((1u << chunk) - 1) << bit);
+        count += __builtin_popcount(rises & mask);
+
+        length -= chunk;
+        from += chunk;
+        if (from == MinutesPerWeek) {
+            from = 0;
+        }
+    }
+
+    return count;
+}
+
+int64_t RelaySchedule::CountRises(const DateTime& from, const DateTime& to) const
+{
+    // The changes happen at the starts of the minutes after "from"
+    int64_t first = DateTime::FloorDiv(from.seconds, DateTime::SecondsPerMinute) + 1;
+    int64_t last = DateTime::FloorDiv(to.seconds, DateTime::SecondsPerMinute);
+    if (last < first) {
+        return 0;
+    }
+
+    int64_t minutes = last - first + 1;
+    int64_t weeks = minutes / MinutesPerWeek;
+    int rest = static_cast<int>(minutes - weeks * MinutesPerWeek);
+
+    int64_t count = 0;
+    if (weeks > 0) {
+        count = weeks * CountRises(0, MinutesPerWeek);
+    }
+
+    int start = MinuteOfWeek(DateTime::FromSeconds(first * DateTime::SecondsPerMinute));
+    return count + CountRises(start, rest);
+}
+
+DateTime RelaySchedule::NextChange(const DateTime& time) const
+{
+    int distance = MinutesToChange(MinuteOfWeek(time));
+    if (distance == 0) {
+        return DateTime::FromSeconds(DateTime::Never);
+    }
+
+    // The changes happen on the minute boundaries
+    DateTime minuteStart = time - time.SecondOfDay() % DateTime::SecondsPerMinute;
+    return minuteStart + distance * DateTime::SecondsPerMinute;
+}
+
+int RelaySchedule::ToWindows(RelayWindow* out, int maxCount) const
+{
+    int count = 0;
+
+    for (int day = 0; day < 7; day++) {
+        int base = day * MinutesPerDay;
+        int minute = 0;
+
+        while (minute < MinutesPerDay) {
+            if (!IsOn(base + minute)) {
+                minute++;
+                continue;
+            }
+
+            int beg = minute;
+            while (minute < MinutesPerDay && IsOn(base + minute)) {
+                minute++;
+            }
+
+            // The same times on another day only extend the weekday mask
+            int i = 0;
+            while (i < count && (out[i].begMinute != beg || out[i].endMinute != minute)) {
+                i++;
+            }
+
+            if (i == count) {
+                if (count == maxCount) {
+                    return -1;
+                }
+                out[count].begMinute = static_cast<uint16_t>(beg);
+                out[count].endMinute = static_cast<uint16_t>(minute);
+                out[count].weekdays = 0;
+                count++;
+            }
+            out[i].weekdays |= static_cast<uint8_t>(1 << day);
+        }
+    }
+
+    return count;
+}
+
+static int ParseDay(const char*& text)
+{
+    for (int day = 0; day < 7; day++) {
+        if (strncmp(text, DayNames[day], 2) == 0) {
+            text += 2;
+            return day;
+        }
+    }
+    return -1;
+}
+
+bool RelaySchedule::ParseWindow(const char* text, RelayWindow& out)
+{
+    while (*text == ' ') {
+        text++;
+    }
+
+    // The optional list of days
+    uint8_t weekdays = 0;
+    while (*text >= 'A' && *text <= 'Z') {
+        int first = ParseDay(text);
+        if (first < 0) {
+            return false;
+        }
+
+        int last = first;
+        if (*text == '-') {
+            text++;
+            last = ParseDay(text);
+            if (last < 0) {
+                return false;
+            }
+        }
+
+        // The range may wrap around the end of the week ("Sa-Mo")
+        for (int day = first; ; day = (day + 1) % 7) {
+            weekdays |= static_cast<uint8_t>(1 << day);
+            if (day == last) {
+                break;
+            }
+        }
+
+        if (*text == ',') {
+            text++;
+        } else if (*text == ' ') {
+            text++;
+            break;
+        } else {
+            return false;
+        }
+    }
+
+    int begHour, begMinute, endHour, endMinute, length = 0;
+    if (sscanf(text, " %d:%d-%d:%d%n", &begHour, &begMinute, &endHour, &endMinute, &length) != 4) {
+        return false;
+    }
+    for (text += length; *text == ' '; text++) {
+    }
+    if (*text != '\0') {
+        return false;
+    }
+
+    if (begHour < 0 || begHour > 23 || begMinute < 0 || begMinute > 59 ||
+        endHour < 0 || endHour > 24 || endMinute < 0 || endMinute > 59 ||
+        (endHour == 24 && endMinute != 0)) {
+        return false;
+    }
+
+    out.begMinute = static_cast<uint16_t>(begHour * 60 + begMinute);
+    out.endMinute = static_cast<uint16_t>(endHour * 60 + endMinute);
+    out.weekdays = (weekdays != 0) ? weekdays : RelayWindow::AllDays;
+    return true;
+}
+
+int RelaySchedule::FormatWindow(const RelayWindow& window, char* buffer, size_t size)
+{
+    char days[32] = "";
+    size_t used = 0;
+
+    if ((window.weekdays & RelayWindow::AllDays) != RelayWindow::AllDays) {
+        // Three or more consecutive days are written as a range
+        int day = 0;
+        while (day < 7) {
+            if (!window.IsActiveOn(day)) {
+                day++;
+                continue;
+            }
+
+            int last = day;
+            while (last + 1 < 7 && window.IsActiveOn(last + 1)) {
+                last++;
+            }
+
+            const char* separator = (used == 0) ? "" : ",";
+            if (last - day >= 2) {
+                used += snprintf(days + used, sizeof(days) - used, "%s%s-%s", separator, DayNames[day], DayNames[last]);
+                day = last + 1;
+            } else {
+                used += snprintf(days + used, sizeof(days) - used, "%s%s", separator, DayNames[day]);
+                day++;
+            }
+        }
+        days[used++] = ' ';
+        days[used] = '\0';
+    }
+
+    return snprintf(buffer, size, "%s%02d:%02d-%02d:%02d", days,
+                    window.begMinute / 60, window.begMinute % 60,
+                    window.endMinute / 60, window.endMinute % 60);
+}
@@ -0,0 +1,98 @@
+/*
+  * RelaySchedule Class
+    * The weekly relay schedule stored as a bitmap with one bit per
+    * minute of the week (10080 bits, 1260 bytes), bit 0 is Monday 00:00.
+    * Any number of windows and weekday patterns can be merged into it,
+    * and "is the relay on now?" is a single bit test.
+    * The windows are the human-readable form, "Mo-Fr 07:50-08:10";
+    * the conversions between them and the bitmap do not depend on
+    * the Pico SDK or FreeRTOS, so they can be used on the host too.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "DateTime.h"
+
+struct RelayWindow {
+    static constexpr uint8_t AllDays = 0x7F;
+
+    uint16_t begMinute = 0; // Minute of the day when the relay turns on
+    uint16_t endMinute = 0; // Minute of the day when it turns off; a lower value
+                            // than begMinute ends on the next day, equal is empty
+    uint8_t weekdays = AllDays; // Days when the window begins, bit 0 is Monday
+
+    bool IsActiveOn(int dayOfWeek) const {
+        return (weekdays & (1 << dayOfWeek)) != 0;
+    }
+
+    // Length of the window in minutes
+    int Length() const;
+};
+
+class RelaySchedule {
+public:
+    static constexpr int MinutesPerDay = 24 * 60;
+    static constexpr int MinutesPerWeek = 7 * MinutesPerDay;
+    static constexpr int WordCount = (MinutesPerWeek + 31) / 32;
+
+    RelaySchedule() { Clear(); }
+
+    void Clear();
+
+    // Turn on the minutes of the window on each of its days
+    void AddWindow(const RelayWindow& window);
+
+    // Turn the minutes [from, from + length) on or off,
+    // the range wraps around the end of the week
+    void SetRange(int from, int length, bool on);
+
+    bool IsOn(int minuteOfWeek) const {
+        return (bits[minuteOfWeek >> 5] >> (minuteOfWeek & 31)) & 1;
+    }
+
+    bool IsOn(const DateTime& time) const {
+        return IsOn(MinuteOfWeek(time));
+    }
+
+    bool IsEmpty() const;
+
+    // Minutes from the given minute of the week to the next
+    // minute with the other state, 0 if the state never changes
+    int MinutesToChange(int minuteOfWeek) const;
+
+    // Amount of the off to on changes at the minutes [from, from + length),
+    // the range wraps around the end of the week
+    int CountRises(int from, int length) const;
+
+    // Amount of the off to on changes in (from, to], in seconds since epoch;
+    // the whole weeks are counted at once, so any jump costs at most
+    // two passes over the bitmap
+    int64_t CountRises(const DateTime& from, const DateTime& to) const;
+
+    // The first moment after the given time when the state changes,
+    // DateTime::Never if it never does
+    DateTime NextChange(const DateTime& time) const;
+
+    // Decode the bitmap into windows which end at midnight at the latest;
+    // the windows with the same times are merged into one weekday mask.
+    // Returns the amount of windows, -1 if they do not fit into maxCount
+    int ToWindows(RelayWindow* out, int maxCount) const;
+
+    static int MinuteOfWeek(const DateTime& time) {
+        return time.DayOfWeek() * MinutesPerDay + static_cast<int>(time.SecondOfDay() / DateTime::SecondsPerMinute);
+    }
+
+    // Parse "[days ]HH:MM-HH:MM", where days is a comma separated list
+    // of the days or day ranges ("Mo-Fr", "Sa,Su", "Mo,We-Fr"),
+    // all the days if omitted; "24:00" is accepted as the end
+    static bool ParseWindow(const char* text, RelayWindow& out);
+
+    // Format the window in the form accepted by ParseWindow,
+    // returns the length of the text as snprintf does
+    static int FormatWindow(const RelayWindow& window, char* buffer, size_t size);
+
+private:
+    uint32_t bits[WordCount];
+};
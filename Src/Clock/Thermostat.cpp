@@ -0,0 +1,77 @@
+/*
+  * Thermostat Class
+    * A two-point controller: heating turns on at or below
+    * setpoint - hysteresis / 2 and off at or above setpoint + hysteresis / 2,
+    * cooling the other way round. The minimum on and off times count
+    * from the last change of the demand, on the monotonic tick time,
+    * so setting the clock does not affect them.
+*/
+
+#include "Thermostat.hpp"
+
+void Thermostat::SetConfig(const ThermostatConfig& newConfig)
+{
+    config.CopyFrom(newConfig);
+    held = false;
+
+    if (!config.enabled) {
+        demand = false;
+        started = false; // The first reading after enabling acts at once
+    }
+}
+
+bool Thermostat::WantsSwitch(float temperatureC) const
+{
+    float low = config.setpoint - config.hysteresis / 2;
+    float high = config.setpoint + config.hysteresis / 2;
+
+    // Inside the band the demand stays as it is
+    bool turnOn = config.cooling ? (temperatureC >= high) : (temperatureC <= low);
+    bool turnOff = config.cooling ? (temperatureC <= low) : (temperatureC >= high);
+
+    return demand ? turnOff : turnOn;
+}
+
+bool Thermostat::Update(float temperatureC, uint32_t nowMs)
+{
+    if (!config.enabled) {
+        return demand;
+    }
+
+    held = false;
+    if (!WantsSwitch(temperatureC)) {
+        return demand;
+    }
+
+    if (TimeToAllowed(nowMs) > 0) {
+        held = true;
+        return demand;
+    }
+
+    demand = !demand;
+    started = true;
+    changedAtMs = nowMs;
+    return demand;
+}
+
+uint32_t Thermostat::GetHoldRemainingMs(uint32_t nowMs) const
+{
+    if (!held) {
+        return 0;
+    }
+
+    // At least a millisecond, the held switch is still to be made
+    uint32_t remaining = TimeToAllowed(nowMs);
+    return (remaining > 0) ? remaining : 1;
+}
+
+uint32_t Thermostat::TimeToAllowed(uint32_t nowMs) const
+{
+    uint32_t holdMs = (demand ? config.minOnSeconds : config.minOffSeconds) * 1000;
+    uint32_t elapsed = nowMs - changedAtMs;
+
+    if (!started || elapsed >= holdMs) {
+        return 0;
+    }
+    return holdMs - elapsed;
+}
@@ -0,0 +1,59 @@
+/*
+  * Thermostat Class
+    * The temperature control of the relay: the relay is demanded on
+    * below the setpoint (above it when cooling) with a hysteresis band
+    * around the setpoint, and every state is held for a minimum time,
+    * so the load is not cycled faster than it allows.
+    * The decision is updated on each temperature reading in O(1);
+    * nothing is polled, the caller is told when a switch held back by
+    * the minimum times becomes allowed.
+    * The time-of-day gate is the relay schedule itself, see RelayMatcher.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+struct ThermostatConfig {
+    bool enabled = false;         // False: the relay follows its schedule only
+    bool cooling = false;         // Demand above the setpoint instead of below
+    bool gated = false;           // Run only inside the relay windows
+    float setpoint = 20.0f;       // Celsius
+    float hysteresis = 1.0f;      // Width of the band around the setpoint
+    uint32_t minOnSeconds = 60;   // Least time the relay stays on
+    uint32_t minOffSeconds = 60;  // Least time the relay stays off
+
+    void CopyFrom(const ThermostatConfig& other) {
+        *this = other;
+    }
+};
+
+class Thermostat {
+public:
+    void SetConfig(const ThermostatConfig& newConfig);
+
+    void GetConfig(ThermostatConfig& outConfig) const {
+        outConfig.CopyFrom(config);
+    }
+
+    // Take a reading at the given monotonic time; returns the demand
+    bool Update(float temperatureC, uint32_t nowMs);
+
+    bool GetDemand() const { return demand; }
+
+    // Milliseconds until a switch, which the last reading asked for but
+    // the minimum times held back, is allowed; 0 if nothing is held back
+    uint32_t GetHoldRemainingMs(uint32_t nowMs) const;
+
+private:
+    bool WantsSwitch(float temperatureC) const;
+
+    // Milliseconds until the current demand may change
+    uint32_t TimeToAllowed(uint32_t nowMs) const;
+
+    ThermostatConfig config;
+    bool demand = false;
+    bool started = false;      // False until the first reading
+    bool held = false;         // The last reading asked for a switch which was held back
+    uint32_t changedAtMs = 0;  // When the demand changed last
+};
@@ -0,0 +1,206 @@
+/*
+  * TimeWindowActuator Class Template
+    * The common part of the alarm and the relay: the on/off state,
+    * the event queue and the configuration access, parameterized by
+    * a compile-time Policy which provides
+    *   Config  - the configuration of a single time window,
+    *   Matcher - the window matching, which holds the configurations,
+    *             tells whether any window is active at a moment and
+    *             counts the windows which fit between two moments,
+    *   SetOutput, PlayFeedback and ShowEvent - what the events do
+    *             with the output pin, the speaker and the main screen.
+    * The policies are resolved at compile time, so a new actuator type
+    * adds neither a runtime dispatch nor a task of its own: all the
+    * actuators share one task which calls Apply for their events.
+*/
+
+#pragma once
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+#include <stdint.h>
+#include "DateTime.h"
+
+class GPIOControl;
+class PiezoSound;
+class MainScreen;
+
+struct ActuatorState {
+    bool ringing = false; // True if the output is currently on
+
+    void CopyFrom(const ActuatorState& other) {
+        ringing = other.ringing;
+    }
+};
+
+enum class ActuatorEventType {
+    On,
+    Off,
+    Reconfigured,
+    Missed,       // Windows opened and closed during a time jump
+};
+
+template <typename Config>
+struct ActuatorEvent {
+    ActuatorEventType type;
+    int index;           // The window which caused the event, -1 if none
+    ActuatorState state; // Current state of the actuator
+    Config config;       // Configuration to show, the next window to fire
+    int missed;          // Amount of the missed windows, Missed only
+};
+
+// The devices the actuator events are applied to
+struct ActuatorOutputs {
+    GPIOControl* gpio;
+    PiezoSound* sound;
+    MainScreen* mainScreen;
+};
+
+template <typename Policy>
+class TimeWindowActuator {
+public:
+    using Config = typename Policy::Config;
+    using Matcher = typename Policy::Matcher;
+    using Event = ActuatorEvent<Config>;
+
+    static constexpr int MaxConfigs = Matcher::MaxConfigs;
+
+    explicit TimeWindowActuator(int qLength) {
+        // Create the event queue
+        outQueue = xQueueCreate(qLength, sizeof(Event));
+    }
+
+    void ProcessCurrentTime(const DateTime& time) {
+        int index = -1;
+        bool active = matcher.IsActive(time.seconds, index);
+
+        if (active && !state.ringing) {
+            state.ringing = true;
+            SendEvent(ActuatorEventType::On, index);
+        } else if (!active && state.ringing) {
+            state.ringing = false;
+            SendEvent(ActuatorEventType::Off, -1);
+        }
+    }
+
+    // Bring the state from one time to another after a jump;
+    // instead of stepping through the seconds the matcher counts the
+    // windows which were entirely skipped, they are reported in a single
+    // Missed event, and the net change comes as an On or Off event
+    void CatchUp(const DateTime& previousTime, const DateTime& newTime) {
+        if (newTime > previousTime) {
+            int index = -1;
+            int missed = matcher.CountMissed(previousTime.seconds, newTime.seconds, index);
+            if (missed > 0) {
+                Event evt = MakeEvent(ActuatorEventType::Missed, index);
+                evt.missed = missed;
+                xQueueSend(outQueue, &evt, 0);
+            }
+        }
+
+        ProcessCurrentTime(newTime);
+    }
+
+    // The first moment after the given time when the
+    // actuator may switch, DateTime::Never if it never does
+    DateTime NextTransition(const DateTime& time) const {
+        return matcher.NextChange(time.seconds);
+    }
+
+    void SetConfig(int index, const Config& newConfig) {
+        if (index < 0 || index >= MaxConfigs) {
+            return;
+        }
+
+        taskENTER_CRITICAL();
+        matcher.SetConfig(index, newConfig);
+        Event evt = MakeEvent(ActuatorEventType::Reconfigured, index);
+        taskEXIT_CRITICAL();
+
+        xQueueSend(outQueue, &evt, 0);
+    }
+
+    // Replace the first count configurations at once, with a single rebuild
+    void SetConfigs(const Config* newConfigs, int count) {
+        if (count > MaxConfigs) {
+            count = MaxConfigs;
+        }
+
+        taskENTER_CRITICAL();
+        matcher.SetConfigs(newConfigs, count);
+        Event evt = MakeEvent(ActuatorEventType::Reconfigured, -1);
+        taskEXIT_CRITICAL();
+
+        xQueueSend(outQueue, &evt, 0);
+    }
+
+    // Change the matcher settings which are not window configurations;
+    // update(matcher) runs in a critical section, as SetConfig does
+    template <typename Update>
+    void UpdateMatcher(Update update) {
+        taskENTER_CRITICAL();
+        update(matcher);
+        Event evt = MakeEvent(ActuatorEventType::Reconfigured, -1);
+        taskEXIT_CRITICAL();
+
+        xQueueSend(outQueue, &evt, 0);
+    }
+
+    void GetConfig(int index, Config& outConfig) const {
+        matcher.GetConfig(index, outConfig);
+    }
+
+    // Configuration of the window which fires next;
+    // returns false if no window is enabled
+    bool GetNextConfig(Config& outConfig) const {
+        return matcher.GetNextConfig(outConfig);
+    }
+
+    void GetState(ActuatorState& outState) const {
+        outState.CopyFrom(state);
+    }
+
+    const Matcher& GetMatcher() const { return matcher; }
+
+    QueueHandle_t GetEventQueue() const { return outQueue; }
+
+    // Carry out an event of this actuator type on the devices
+    static void Apply(const ActuatorOutputs& outputs, const Event& evt) {
+        switch (evt.type) {
+            case ActuatorEventType::On:
+                Policy::SetOutput(*outputs.gpio, true);
+                break;
+
+            case ActuatorEventType::Off:
+                Policy::SetOutput(*outputs.gpio, false);
+                break;
+
+            case ActuatorEventType::Reconfigured:
+            case ActuatorEventType::Missed:
+                break;
+        }
+
+        Policy::ShowEvent(*outputs.mainScreen, evt);
+        Policy::PlayFeedback(*outputs.sound, evt.type);
+    }
+
+private:
+    Event MakeEvent(ActuatorEventType type, int index) const {
+        Event evt{type, index, state, {}, 0};
+        if (!matcher.GetNextConfig(evt.config)) {
+            evt.config.enabled = false;
+        }
+        return evt;
+    }
+
+    void SendEvent(ActuatorEventType type, int index) {
+        Event evt = MakeEvent(type, index);
+        xQueueSend(outQueue, &evt, 0);
+    }
+
+    Matcher matcher;
+    ActuatorState state;
+
+    QueueHandle_t outQueue;
+};
@@ -17,6 +17,7 @@
 Display::Display(HD44780* lcd)
 {
     physicalDisplay = lcd;
+    ResetShadow();
     commandQueue = xQueueCreate(8, sizeof(DisplayCommand));
 
     // Add custom symbos for ringing bell (in form of solid bell) 
@@ -170,6 +171,7 @@ void Display::ProcessCommand(const DisplayCommand& cmd)
     switch (cmd.type) {
         case DisplayCommandType::Clear:
             physicalDisplay->Clear();
+            ResetShadow();
             break;
 
         case DisplayCommandType::SetBacklight:
@@ -177,13 +179,68 @@ void Display::ProcessCommand(const DisplayCommand& cmd)
             break;
 
         case DisplayCommandType::PrintSymbol:
-            physicalDisplay->PrintCustomCharacter(
-                cmd.symbol.row, cmd.symbol.col, cmd.symbol.location);
+            // Only 8 locations available
+            if (cmd.symbol.location < 8) {
+                UpdateCells(cmd.symbol.row, cmd.symbol.col, &cmd.symbol.location, 1);
+            }
             break;
 
         case DisplayCommandType::PrintLine:
-            physicalDisplay->SetCursor(cmd.showText.row, cmd.showText.col);
-            physicalDisplay->PrintString(cmd.showText.text);
+            UpdateCells(cmd.showText.row, cmd.showText.col,
+                reinterpret_cast<const uint8_t*>(cmd.showText.text),
+                strlen(cmd.showText.text));
             break;
     }
 }
+
+void Display::ResetShadow()
+{
+    // After the clear command the DDRAM is filled with spaces
+    memset(shadow, ' ', sizeof(shadow));
+}
+
+void Display::UpdateCells(int row, int col, const uint8_t* cells, int length)
+{
+    if (row < 0 || row >= Rows || col < 0 || col >= Cols) {
+        return; // Out of the screen
+    }
+
+    // Clip the text at the end of the row,
+    // we do not rely on the controller line wrapping
+    if (length > Cols - col) {
+        length = Cols - col;
+    }
+
+    // Coalesce adjacent dirty cells into runs,
+    // so every run costs one cursor-set command
+    int runBeg = -1;
+    for (int i = 0; i < length; ++i) {
+        bool dirty = shadow[row][col + i] != cells[i];
+        if (dirty) {
+            if (runBeg < 0) {
+                runBeg = i;
+            }
+            continue;
+        }
+
+        stats.bytesSuppressed++;
+        if (runBeg >= 0) {
+            FlushRun(row, col + runBeg, &cells[runBeg], i - runBeg);
+            runBeg = -1;
+        }
+    }
+
+    if (runBeg >= 0) {
+        FlushRun(row, col + runBeg, &cells[runBeg], length - runBeg);
+    }
+}
+
+void Display::FlushRun(int row, int col, const uint8_t* cells, int length)
+{
+    physicalDisplay->SetCursor(row, col);
+    physicalDisplay->PrintSymbols(cells, length);
+    memcpy(&shadow[row][col], cells, length);
+
+    // One cursor-set command plus the cell bytes
+    stats.bytesSent += 1 + length;
+}
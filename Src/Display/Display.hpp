@@ -51,8 +51,19 @@ struct DisplayCommand {
     };
 };
 
+// Traffic counters of the shadow framebuffer.
+// Bytes are counted as they would go to the LCD controller:
+// one per cursor-set command and one per character cell.
+struct DisplayStats {
+    uint32_t bytesSent = 0;       // bytes actually sent to the LCD
+    uint32_t bytesSuppressed = 0; // cell bytes skipped because the LCD already shows them
+};
+
 class Display : public IDisplay {
 public:
+    static constexpr int Rows = 4;
+    static constexpr int Cols = 20;
+
     Display(HD44780* lcd);
 
     void Clear() override;
@@ -60,10 +71,22 @@ public:
     void PrintLine(int row, int col, const char* text) override;
     void PrintCustomCharacter(uint8_t row, uint8_t col, uint8_t location) override;
 
+    void GetStats(DisplayStats& outStats) const { outStats = stats; }
+
 private:
     static void TaskLoop(void* param);
     void ProcessCommand(const DisplayCommand& cmd);
 
+    // Shadow framebuffer handling: compare the requested cells
+    // with the copy of DDRAM and send only the differing runs
+    void ResetShadow();
+    void UpdateCells(int row, int col, const uint8_t* cells, int length);
+    void FlushRun(int row, int col, const uint8_t* cells, int length);
+
+    // Copy of what the LCD currently shows
+    uint8_t shadow[Rows][Cols];
+    DisplayStats stats;
+
     QueueHandle_t commandQueue;
     HD44780* physicalDisplay; // Assuming HD44780 is a class for the LCD driver
 };
@@ -14,5 +14,5 @@ public:
     virtual void Clear() = 0;
     virtual void SetBacklight(bool on) = 0;
     virtual void PrintLine(int row, int col, const char* text) = 0;
-    virtual void PrintCustomCharacter(uint8_t row, uint8_t col, uint8_t location);
+    virtual void PrintCustomCharacter(uint8_t row, uint8_t col, uint8_t location) = 0;
 };
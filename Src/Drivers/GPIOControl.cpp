@@ -1,7 +1,13 @@
 /*
     The GPIO Signal controller for the Raspberry Pi Pico
-    This class handles GPIO operations such as GPIO 
+    This class handles GPIO operations such as GPIO
     pin state changes and also blinking a LED.
+    The relay bank pins are switched together: a channel mask is
+    applied in one gpio_put_masked write, and the channels which turn
+    on can be staggered to limit the inrush current.
+    Nothing in the command task waits: the LED patterns and the
+    stagger steps are run by software timers, so an actuator command
+    is applied as soon as the task takes it from the queue.
 */
 
 #include "FreeRTOS.h"
@@ -11,6 +17,10 @@
 
 #include "GPIOControl.hpp"
 
+static const uint16_t TickPatternSteps[] = {100, 100, 100};
+
+const LedPattern GPIOControl::TickPattern = {TickPatternSteps, 3, false};
+
 GPIOControl::GPIOControl(int pinTickLed, int pinAlrmCtrl, int pinRelayCtrl)
 {
     pin_tick_led = pinTickLed;
@@ -22,6 +32,10 @@ GPIOControl::GPIOControl(int pinTickLed, int pinAlrmCtrl, int pinRelayCtrl)
 
     commandQueue = xQueueCreate(8, sizeof(GPIOCommand));
 
+    // One-shot timers, every callback sets the period of the next step
+    led_timer = xTimerCreate("LedPattern", 1, pdFALSE, this, LedTimerCallback);
+    bank_timer = xTimerCreate("RelayStagger", 1, pdFALSE, this, BankTimerCallback);
+
     Start();
 }
 
@@ -30,19 +44,137 @@ void GPIOControl::BlinkTickLed()
     EnqueeCommand(GPIOCommandType::BlinkClockTick);
 }
 
-void GPIOControl::InnerBlinkTickLed()
+void GPIOControl::PlayLedPattern(const LedPattern& pattern)
+{
+    GPIOCommand cmd = {};
+    cmd.type = GPIOCommandType::PlayLedPattern;
+    cmd.pattern = &pattern;
+    SendCommand(cmd);
+}
+
+void GPIOControl::StartLedPattern(const LedPattern* pattern)
+{
+    // Picked up by the timer callback on its next run
+    led_requested = pattern;
+    xTimerChangePeriod(led_timer, 1, 0);
+}
+
+void GPIOControl::LedTimerCallback(TimerHandle_t timer)
+{
+    static_cast<GPIOControl*>(pvTimerGetTimerID(timer))->AdvanceLedPattern();
+}
+
+void GPIOControl::AdvanceLedPattern()
+{
+    // The timer task has the highest priority, the command
+    // task cannot change the request in the middle of this
+    const LedPattern* requested = led_requested;
+    if (requested != nullptr) {
+        led_requested = nullptr;
+        led_pattern = requested;
+        led_step = 0;
+    } else if (led_pattern != nullptr) {
+        led_step++;
+    }
+
+    if (led_pattern == nullptr) {
+        return;
+    }
+
+    if (led_step >= led_pattern->count) {
+        if (!led_pattern->repeat || led_pattern->count == 0) {
+            led_pattern = nullptr;
+            gpio_put(pin_tick_led, 0);
+            return;
+        }
+        led_step = 0;
+    }
+
+    gpio_put(pin_tick_led, (led_step & 1) == 0);
+
+    TickType_t period = pdMS_TO_TICKS(led_pattern->stepsMs[led_step]);
+    xTimerChangePeriod(led_timer, period > 0 ? period : 1, 0);
+}
+
+void GPIOControl::SetRelayBankPins(const uint8_t* pins, int count, uint32_t staggerMs)
+{
+    bank_count = 0;
+    bank_pin_mask = 0;
+    bank_stagger_ms = staggerMs;
+
+    for (int i = 0; i < count && bank_count < MaxBankPins; i++) {
+        if (pins[i] >= 32) {
+            continue; // The masked write reaches GPIO 0-31 only
+        }
+        bank_pins[bank_count++] = pins[i];
+        bank_pin_mask |= 1u << pins[i];
+        PrepareGPIO(pins[i]);
+    }
+    bank_pin_state = 0;
+    bank_pending = 0;
+}
+
+void GPIOControl::SetRelayBank(uint32_t channelMask)
 {
-    gpio_put(pin_tick_led, 1);
-    vTaskDelay(100);
+    GPIOCommand cmd = {};
+    cmd.type = GPIOCommandType::SetRelayBank;
+    cmd.mask = channelMask;
+    SendCommand(cmd);
+}
+
+void GPIOControl::InnerSetRelayBank(uint32_t channelMask)
+{
+    uint32_t target = 0;
+    for (int i = 0; i < bank_count; i++) {
+        if (channelMask & (1u << i)) {
+            target |= 1u << bank_pins[i];
+        }
+    }
+
+    // The channels turning off go at once, together with the first
+    // one turning on; the rest follow one by one from the timer
+    taskENTER_CRITICAL();
+    uint32_t rising = target & ~bank_pin_state;
+    uint32_t state = target & ~rising;
+    if (rising != 0) {
+        state |= rising & -rising;
+        rising &= rising - 1;
+    }
+    if (bank_stagger_ms == 0) {
+        state |= rising;
+        rising = 0;
+    }
+
+    gpio_put_masked(bank_pin_mask, state);
+    bank_pin_state = state;
+    bank_pending = rising;
+    taskEXIT_CRITICAL();
+
+    if (rising != 0) {
+        xTimerChangePeriod(bank_timer, pdMS_TO_TICKS(bank_stagger_ms), 0);
+    }
+}
 
-    gpio_put(pin_tick_led, 0);
-    vTaskDelay(100);
+void GPIOControl::BankTimerCallback(TimerHandle_t timer)
+{
+    static_cast<GPIOControl*>(pvTimerGetTimerID(timer))->StaggerRelayBank();
+}
 
-    gpio_put(pin_tick_led, 1);
-    vTaskDelay(100);
+void GPIOControl::StaggerRelayBank()
+{
+    taskENTER_CRITICAL();
+    uint32_t pending = bank_pending;
+    if (pending != 0) {
+        bank_pin_state |= pending & -pending;
+        bank_pending = pending & (pending - 1);
+        gpio_put_masked(bank_pin_mask, bank_pin_state);
+    }
+    pending = bank_pending;
+    taskEXIT_CRITICAL();
 
-    gpio_put(pin_tick_led, 0);
-    vTaskDelay(700);
+    if (pending != 0) {
+        xTimerChangePeriod(bank_timer, pdMS_TO_TICKS(bank_stagger_ms), 0);
+    }
 }
 
 void GPIOControl::Start()
@@ -58,6 +190,13 @@ void GPIOControl::TaskLoop(void* param)
     while (true) {
         if (xQueueReceive(self->commandQueue, &cmd, portMAX_DELAY)) {
             self->ProcessCommand(cmd);
+
+            uint32_t latency = time_us_32() - cmd.queuedUs;
+            self->stats.commands++;
+            self->stats.lastLatencyUs = latency;
+            if (latency > self->stats.maxLatencyUs) {
+                self->stats.maxLatencyUs = latency;
+            }
         }
     }
 }
@@ -74,6 +213,12 @@ void GPIOControl::EnqueeCommand(GPIOCommandType cmdType)
 {
     GPIOCommand cmd = {};
     cmd.type = cmdType;
+    SendCommand(cmd);
+}
+
+void GPIOControl::SendCommand(GPIOCommand& cmd)
+{
+    cmd.queuedUs = time_us_32();
     xQueueSend(commandQueue, &cmd, portMAX_DELAY);
 }
 
@@ -98,7 +243,15 @@ void GPIOControl::ProcessCommand(const GPIOCommand& cmd)
             break;
 
         case GPIOCommandType::BlinkClockTick:
-            InnerBlinkTickLed();
+            StartLedPattern(&TickPattern);
+            break;
+
+        case GPIOCommandType::PlayLedPattern:
+            StartLedPattern(cmd.pattern);
+            break;
+
+        case GPIOCommandType::SetRelayBank:
+            InnerSetRelayBank(cmd.mask);
             break;
 
         default:
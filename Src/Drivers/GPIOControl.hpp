@@ -1,13 +1,21 @@
 /*
     The GPIO Signal controller for the Raspberry Pi Pico
-    This class handles GPIO operations such as GPIO 
+    This class handles GPIO operations such as GPIO
     pin state changes and also blinking a LED.
+    The relay bank pins are switched together: a channel mask is
+    applied in one gpio_put_masked write, and the channels which turn
+    on can be staggered to limit the inrush current.
+    Nothing in the command task waits: the LED patterns and the
+    stagger steps are run by software timers, so an actuator command
+    is applied as soon as the task takes it from the queue.
 */
 
 #pragma once
 
 #include <stdint.h>
+#include "FreeRTOS.h"
 #include "queue.h"
+#include "timers.h"
 
 enum class GPIOCommandType {
     SetAlarmOn,
@@ -15,10 +23,30 @@ enum class GPIOCommandType {
     SetRelayOn,
     SetRelayOff,
     BlinkClockTick,
+    SetRelayBank,
+    PlayLedPattern,
+};
+
+// A LED blink pattern: the LED is on during the even steps and off
+// during the odd ones, and off after the last step unless it repeats
+struct LedPattern {
+    const uint16_t* stepsMs;
+    uint8_t count;
+    bool repeat;
 };
 
 struct GPIOCommand {
     GPIOCommandType type;
+    uint32_t mask;             // Channels of the relay bank, SetRelayBank only
+    const LedPattern* pattern; // PlayLedPattern only
+    uint32_t queuedUs;         // When the command was queued
+};
+
+// Delays of the commands from queueing to the pin change
+struct GPIOStats {
+    uint32_t commands = 0;      // Amount of processed commands
+    uint32_t lastLatencyUs = 0; // Delay of the last command
+    uint32_t maxLatencyUs = 0;  // Worst delay of a command
 };
 
 class GPIOControl
@@ -31,17 +59,58 @@ public:
     void RelayOff() { EnqueeCommand(GPIOCommandType::SetRelayOff); }
     void BlinkTickLed();
 
+    // Start the pattern on the tick LED, replacing the one which runs;
+    // the pattern must stay valid while it is played
+    void PlayLedPattern(const LedPattern& pattern);
+
+    // Assign the pins of the relay bank (GPIO 0-31), channel i is pins[i];
+    // the channels turning on at once are switched staggerMs apart
+    void SetRelayBankPins(const uint8_t* pins, int count, uint32_t staggerMs = 0);
+
+    // Switch the bank to the given channel mask
+    void SetRelayBank(uint32_t channelMask);
+
+    void GetStats(GPIOStats& outStats) const { outStats = stats; }
+
+    static constexpr int MaxBankPins = 32;
+
+    // Two short blinks, the tick of the clock
+    static const LedPattern TickPattern;
+
 private:
     void PrepareGPIO(int pin, int initialState = 0);
     void EnqueeCommand(GPIOCommandType cmdType);
+    void SendCommand(GPIOCommand& cmd);
     void ProcessCommand(const GPIOCommand& cmd);
     static void TaskLoop(void* param);
-    void InnerBlinkTickLed();
+    static void LedTimerCallback(TimerHandle_t timer);
+    static void BankTimerCallback(TimerHandle_t timer);
+    void StartLedPattern(const LedPattern* pattern);
+    void AdvanceLedPattern();
+    void InnerSetRelayBank(uint32_t channelMask);
+    void StaggerRelayBank();
     void Start();
 
 private:
     uint8_t pin_tick_led;
     uint8_t pin_alrm_ctrl;
     uint8_t pin_relay_ctrl;
+
+    // The LED pattern runs in the timer task; the command task
+    // only hands a new pattern over through led_requested
+    TimerHandle_t led_timer = nullptr;
+    const LedPattern* volatile led_requested = nullptr;
+    const LedPattern* led_pattern = nullptr;
+    int led_step = 0;
+
+    uint8_t bank_pins[MaxBankPins];
+    int bank_count = 0;
+    uint32_t bank_pin_mask = 0; // All the pins of the bank
+    uint32_t bank_pin_state = 0; // The pins of the bank which are on
+    uint32_t bank_pending = 0;  // The pins still to turn on by the stagger
+    uint32_t bank_stagger_ms = 0;
+    TimerHandle_t bank_timer = nullptr;
+
+    GPIOStats stats;
     QueueHandle_t commandQueue;
 };
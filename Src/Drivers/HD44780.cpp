@@ -3,6 +3,8 @@
   * This implementation assumes a 4-bit interface and uses the I2C protocol.
 */
 
+#include <string.h>
+
 #include "hardware/i2c.h"
 #include "pico/stdlib.h"
 
@@ -10,13 +12,15 @@
 
 #define LCD_BACKLIGHT 0x08
 #define ENABLE_BIT 0x04
+#define RW_BIT 0x02
 #define RS_BIT 0x01
+#define BUSY_FLAG 0x80
 
 HD44780::HD44780(uint8_t i2c_address, int i2c_port)
     : _i2c_address(i2c_address), _i2c_port(i2c_port),
-      _backlight(LCD_BACKLIGHT) {}
+      _backlight(LCD_BACKLIGHT), _transmitter(i2c_address, i2c_port) {}
 
-void HD44780::Init()
+void HD44780::Init(bool useBusyFlag)
 {
 
   // Initialize I2C
@@ -28,6 +32,9 @@ void HD44780::Init()
   gpio_pull_up((_i2c_port == 0) ? 4 : 6);
   gpio_pull_up((_i2c_port == 0) ? 5 : 7);
 
+  // Prepare the DMA path for the batched writes
+  _transmitter.Init();
+
   sleep_ms(50);       // Wait for the LCD to power up
   WriteHalf(0x30);    // Initialize the LCD in 4-bit mode
 
@@ -45,29 +52,53 @@ void HD44780::Init()
   sleep_ms(2);        // Wait for the clear command to complete
   WriteCommand(0x06); // Entry mode
   WriteCommand(0x0C); // Display on, no cursor
+
+  // Probe the busy flag: without R/W wired the flag
+  // reads back as set and the probe times out
+  _busy_polling = useBusyFlag;
+  _busy_polling = WaitReady();
+  _stats.busyFlagPolling = _busy_polling;
 }
 
 void HD44780::Clear()
 {
+  uint32_t start = time_us_32();
+
   WriteCommand(0x01);
-  sleep_ms(2);
+  if (!WaitReady()) {
+    _transmitter.WaitIdle(); // The delay counts from the actual command
+    sleep_ms(2);
+  }
+
+  RecordTiming(HD44780Op::Clear, start);
 }
 
 void HD44780::SetCursor(uint8_t row, uint8_t col)
 {
+  uint32_t start = time_us_32();
+
   static const uint8_t row_offsets[] = {0x00, 0x40, 0x14, 0x54};
   WriteCommand(0x80 | (col + row_offsets[row]));
+
+  RecordTiming(HD44780Op::SetCursor, start);
 }
 
 void HD44780::PrintString(const char *text)
 {
-  while (*text) {
-    PrintSymbol(*text++);
-  }
+  PrintSymbols(reinterpret_cast<const uint8_t *>(text), strlen(text));
 }
 
 void HD44780::PrintSymbol(char c) { WriteByte(c, RS_BIT); }
 
+void HD44780::PrintSymbols(const uint8_t *symbols, size_t length)
+{
+  uint32_t start = time_us_32();
+
+  WriteBuffer(symbols, length, RS_BIT);
+
+  RecordTiming(HD44780Op::Write, start);
+}
+
 void HD44780::SetBacklight(bool backlight)
 {
   _backlight = backlight ? LCD_BACKLIGHT : 0;
@@ -94,12 +125,14 @@ void HD44780::CreateCustomCharacter(uint8_t location, uint8_t charmap[])
     return; // Invalid location
   } 
   
+  uint32_t start = time_us_32();
+
   // Custom characters are stored in CGRAM
   WriteCommand(0x40 | (location << 3)); // Set CGRAM address
-  for (int i = 0; i < 8; i++) {
-    WriteData(charmap[i]); // Write character data
-  }
+  WriteBuffer(charmap, 8, RS_BIT);      // Write character data
   WriteCommand(0x80); // Return to DDRAM
+
+  RecordTiming(HD44780Op::CreateChar, start);
 }
 
 void HD44780::WriteCommand(uint8_t cmd) { WriteByte(cmd, 0); }
@@ -107,15 +140,51 @@ void HD44780::WriteCommand(uint8_t cmd) { WriteByte(cmd, 0); }
 void HD44780::WriteData(uint8_t data) { WriteByte(data, RS_BIT); }
 
 void HD44780::WriteByte(uint8_t value, uint8_t mode)
+{
+  WriteBuffer(&value, 1, mode);
+}
+
+void HD44780::WriteBuffer(const uint8_t *values, size_t length, uint8_t mode)
+{
+  // Every I2C byte takes ~90us at 100kHz, which is longer than
+  // both the enable pulse width and the command execution time,
+  // so the whole sequence can go in one transaction without delays
+  uint8_t wire[BATCH_BYTES * WIRE_BYTES_PER_BYTE];
+
+  while (length > 0) {
+    size_t count = (length < BATCH_BYTES) ? length : BATCH_BYTES;
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+      used += EncodeByte(values[i], mode, &wire[used]);
+    }
+
+    _transmitter.Transmit(wire, used);
+
+    values += count;
+    length -= count;
+  }
+}
+
+size_t HD44780::EncodeByte(uint8_t value, uint8_t mode, uint8_t *out) const
 {
   uint8_t high = (value & 0xF0) | _backlight | mode;
   uint8_t low = ((value << 4) & 0xF0) | _backlight | mode;
-  WriteHalf(high);
-  WriteHalf(low);
+
+  // Same sequence as WriteHalf + PulseEnable for each nibble
+  out[0] = high;
+  out[1] = high | ENABLE_BIT;
+  out[2] = high & ~ENABLE_BIT;
+  out[3] = low;
+  out[4] = low | ENABLE_BIT;
+  out[5] = low & ~ENABLE_BIT;
+
+  return WIRE_BYTES_PER_BYTE;
 }
 
 void HD44780::WriteHalf(uint8_t value)
 {
+  _transmitter.WaitIdle(); // Do not mix with the DMA transfer in progress
+
   i2c_write_blocking((_i2c_port == 0) ? i2c0 : i2c1, 
                       _i2c_address, &value, 1, true);
   PulseEnable(value);
@@ -129,7 +198,69 @@ void HD44780::PulseEnable(uint8_t data)
   i2c_write_blocking((_i2c_port == 0) ? i2c0 : i2c1, _i2c_address,
                      &data_with_enable, 1, true);
   sleep_us(1);
+  // The STOP releases the bus, a held bus keeps the ACTIVITY
+  // status bit set and the next WaitIdle would never return
   i2c_write_blocking((_i2c_port == 0) ? i2c0 : i2c1, _i2c_address,
-                     &data_without_enable, 1, true);
+                     &data_without_enable, 1, false);
   sleep_us(50);
 }
+
+bool HD44780::WaitReady()
+{
+  if (!_busy_polling) {
+    return false;
+  }
+
+  // The read-back is a plain blocking transaction,
+  // so the queued batches must be on the wire first
+  _transmitter.WaitIdle();
+
+  uint32_t start = time_us_32();
+  while (time_us_32() - start < BUSY_TIMEOUT_US) {
+    uint8_t high = ReadNibble(RW_BIT);
+    ReadNibble(RW_BIT); // The low nibble holds the address counter
+
+    if (!(high & BUSY_FLAG)) {
+      return true;
+    }
+  }
+
+  // The flag never cleared, the R/W line is likely not connected
+  _busy_polling = false;
+  _stats.busyFlagPolling = false;
+  return false;
+}
+
+uint8_t HD44780::ReadNibble(uint8_t mode)
+{
+  i2c_inst_t *i2c = (_i2c_port == 0) ? i2c0 : i2c1;
+
+  // PCF8574 pins are quasi-bidirectional: writing 1s
+  // to D4-D7 lets the LCD drive them while E is high
+  uint8_t idle = 0xF0 | _backlight | mode;
+  uint8_t enable = idle | ENABLE_BIT;
+  uint8_t value = 0xFF;
+
+  i2c_write_blocking(i2c, _i2c_address, &enable, 1, false);
+  if (i2c_read_blocking(i2c, _i2c_address, &value, 1, false) < 0) {
+    value = 0xFF; // No answer is handled as busy
+  }
+  i2c_write_blocking(i2c, _i2c_address, &idle, 1, false);
+
+  return value & 0xF0;
+}
+
+void HD44780::RecordTiming(HD44780Op op, uint32_t startUs)
+{
+  uint32_t elapsed = time_us_32() - startUs;
+  HD44780OpTiming &timing = _stats.ops[static_cast<int>(op)];
+
+  timing.count++;
+  timing.lastUs = elapsed;
+  if (elapsed < timing.minUs) {
+    timing.minUs = elapsed;
+  }
+  if (elapsed > timing.maxUs) {
+    timing.maxUs = elapsed;
+  }
+}
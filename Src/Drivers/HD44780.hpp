@@ -5,29 +5,79 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include "I2CDmaTransmitter.hpp"
+
+// Operations measured by the driver
+enum class HD44780Op {
+  Clear,
+  SetCursor,
+  Write,      // Data batch handed to the transmitter
+  CreateChar,
+  Count
+};
+
+// Timing of a single operation in microseconds
+struct HD44780OpTiming {
+  uint32_t count = 0;
+  uint32_t lastUs = 0;
+  uint32_t minUs = UINT32_MAX;
+  uint32_t maxUs = 0;
+};
+
+struct HD44780Stats {
+  bool busyFlagPolling = false; // True if the busy flag read-back is in use
+  HD44780OpTiming ops[static_cast<int>(HD44780Op::Count)];
+};
+
 class HD44780 {
 public:
   HD44780(uint8_t i2c_address, int i2c_port = 0);
 
-  void Init();
+  // useBusyFlag: try to read the busy flag back through the PCF8574
+  // (requires R/W wired to P1), otherwise use the fixed delays
+  void Init(bool useBusyFlag = false);
   void Clear();
   void SetCursor(uint8_t row, uint8_t col);
   void PrintString(const char *text);
   void PrintSymbol(char c);
+  void PrintSymbols(const uint8_t *symbols, size_t length);
   void SetBacklight(bool backlight);
   void CreateCustomCharacter(uint8_t location, uint8_t charmap[]);
   void PrintCustomCharacter(uint8_t row, uint8_t col, uint8_t location);
 
+  void GetStats(HD44780Stats &outStats) const { outStats = _stats; }
+
 private:
+  bool WaitReady();
+  uint8_t ReadNibble(uint8_t mode);
+  void RecordTiming(HD44780Op op, uint32_t startUs);
+
   void WriteCommand(uint8_t cmd);
   void WriteData(uint8_t data);
   void WriteByte(uint8_t value, uint8_t mode);
+  void WriteBuffer(const uint8_t *values, size_t length, uint8_t mode);
+  size_t EncodeByte(uint8_t value, uint8_t mode, uint8_t *out) const;
   void WriteHalf(uint8_t value);
   void PulseEnable(uint8_t data);
 
+  // Max amount of bytes encoded into a single I2C transaction,
+  // every LCD byte takes 6 bytes on the wire (2 nibbles, 3 writes each)
+  static constexpr size_t BATCH_BYTES = 20;
+  static constexpr size_t WIRE_BYTES_PER_BYTE = 6;
+
   uint8_t _i2c_address;
   int _i2c_port;
   uint8_t _backlight;
+  bool _busy_polling = false;
+
+  // Give up waiting for the busy flag after this time
+  static constexpr uint32_t BUSY_TIMEOUT_US = 5000;
+
+  HD44780Stats _stats;
+
+  // Sends the encoded batches without blocking the CPU
+  I2CDmaTransmitter _transmitter;
 };
@@ -0,0 +1,163 @@
+/*
+  * Asynchronous I2C transmitter for Raspberry Pi Pico
+  * This class hands pre-encoded byte buffers to a DMA channel
+  * which feeds the I2C TX FIFO, so the CPU stays free while
+  * the bytes go out on the wire.
+  * Completion is signalled to the transmitting task with a task notification.
+  * Before the FreeRTOS scheduler is running it falls back to blocking writes.
+*/
+
+#include "hardware/dma.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "pico/stdlib.h"
+
+#include "I2CDmaTransmitter.hpp"
+
+// Longest transfer takes ~12ms at 100kHz,
+// if there is no completion by then the slave did not respond
+#define TRANSFER_TIMEOUT_MS 50
+
+I2CDmaTransmitter *I2CDmaTransmitter::_instance = nullptr;
+
+I2CDmaTransmitter::I2CDmaTransmitter(uint8_t i2c_address, int i2c_port)
+    : _i2c_address(i2c_address), _i2c_port(i2c_port) {}
+
+void I2CDmaTransmitter::Init()
+{
+  i2c_inst_t *i2c = (_i2c_port == 0) ? i2c0 : i2c1;
+
+  _dma_channel = dma_claim_unused_channel(false);
+  if (_dma_channel < 0) {
+    return; // No free channel, keep using blocking writes
+  }
+
+  dma_channel_config cfg = dma_channel_get_default_config(_dma_channel);
+  channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+  channel_config_set_read_increment(&cfg, true);
+  channel_config_set_write_increment(&cfg, false);
+  channel_config_set_dreq(&cfg, i2c_get_dreq(i2c, true));
+  dma_channel_configure(_dma_channel, &cfg, &i2c_get_hw(i2c)->data_cmd,
+                        _words, 0, false);
+
+  _instance = this;
+  irq_add_shared_handler(DMA_IRQ_0, DmaIrqHandler,
+                         PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_0, true);
+  dma_channel_set_irq0_enabled(_dma_channel, true);
+}
+
+void I2CDmaTransmitter::Transmit(const uint8_t *data, size_t length)
+{
+  i2c_inst_t *i2c = (_i2c_port == 0) ? i2c0 : i2c1;
+
+  if (length == 0) {
+    return;
+  }
+
+  // The interrupt driven path needs a task to notify
+  if (_dma_channel < 0 || !IsSchedulerRunning()) {
+    i2c_write_blocking(i2c, _i2c_address, data, length, false);
+    _target_set = false; // The SDK may have changed the target address
+    return;
+  }
+
+  // The buffer is in use until the previous transfer is done
+  WaitComplete();
+
+  if (length > MAX_TRANSFER) {
+    length = MAX_TRANSFER;
+  }
+
+  for (size_t i = 0; i < length; i++) {
+    _words[i] = data[i];
+  }
+  _words[length - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+  if (!_target_set) {
+    // The target address can be changed only
+    // when the previous transaction has left the FIFO
+    WaitIdle();
+
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+    hw->enable = 0;
+    hw->tar = _i2c_address;
+    hw->enable = 1;
+    _target_set = true;
+  }
+
+  // A completion which came after a timeout must not
+  // be taken for the end of this transfer
+  ulTaskNotifyValueClear(nullptr, 0xFFFFFFFF);
+  xTaskNotifyStateClear(nullptr);
+
+  _waiting_task = xTaskGetCurrentTaskHandle();
+  _in_flight = true;
+  dma_channel_transfer_from_buffer_now(_dma_channel, _words, length);
+}
+
+void I2CDmaTransmitter::WaitComplete()
+{
+  if (!_in_flight) {
+    return;
+  }
+
+  if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TRANSFER_TIMEOUT_MS)) == 0) {
+    // The slave did not acknowledge and the I2C block
+    // flushed the FIFO, so the DMA will never finish.
+    // The interrupt is off during the abort, which may raise it
+    _waiting_task = nullptr;
+    i2c_inst_t *i2c = (_i2c_port == 0) ? i2c0 : i2c1;
+    dma_channel_set_irq0_enabled(_dma_channel, false);
+    dma_channel_abort(_dma_channel);
+    dma_channel_acknowledge_irq0(_dma_channel);
+    dma_channel_set_irq0_enabled(_dma_channel, true);
+    (void)i2c_get_hw(i2c)->clr_tx_abrt;
+
+    // The completion may have come just after the timeout
+    ulTaskNotifyValueClear(nullptr, 0xFFFFFFFF);
+    xTaskNotifyStateClear(nullptr);
+    _errors++;
+  }
+
+  _in_flight = false;
+  _waiting_task = nullptr;
+}
+
+void I2CDmaTransmitter::WaitIdle()
+{
+  WaitComplete();
+
+  i2c_hw_t *hw = i2c_get_hw((_i2c_port == 0) ? i2c0 : i2c1);
+  while (!(hw->status & I2C_IC_STATUS_TFE_BITS) ||
+         (hw->status & I2C_IC_STATUS_ACTIVITY_BITS)) {
+    if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+      (void)hw->clr_tx_abrt;
+      break;
+    }
+    if (IsSchedulerRunning()) {
+      vTaskDelay(1);
+    }
+  }
+}
+
+bool I2CDmaTransmitter::IsSchedulerRunning() const
+{
+  return xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+
+void I2CDmaTransmitter::DmaIrqHandler()
+{
+  I2CDmaTransmitter *self = _instance;
+  if (self == nullptr || !dma_channel_get_irq0_status(self->_dma_channel)) {
+    return; // Not our channel, the handler is shared
+  }
+
+  dma_channel_acknowledge_irq0(self->_dma_channel);
+
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  if (self->_waiting_task != nullptr) {
+    vTaskNotifyGiveFromISR(self->_waiting_task, &higherPriorityTaskWoken);
+  }
+  portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
@@ -0,0 +1,61 @@
+/*
+  * Asynchronous I2C transmitter for Raspberry Pi Pico
+  * This class hands pre-encoded byte buffers to a DMA channel
+  * which feeds the I2C TX FIFO, so the CPU stays free while
+  * the bytes go out on the wire.
+  * Completion is signalled to the transmitting task with a task notification.
+  * Before the FreeRTOS scheduler is running it falls back to blocking writes.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+class I2CDmaTransmitter {
+public:
+  I2CDmaTransmitter(uint8_t i2c_address, int i2c_port = 0);
+
+  // Claim the DMA channel and install the completion interrupt handler
+  void Init();
+
+  // Start sending the bytes in one I2C transaction;
+  // waits only for the previous transfer to leave the buffer
+  void Transmit(const uint8_t *data, size_t length);
+
+  // Wait until all the bytes are actually sent out on the wire
+  void WaitIdle();
+
+  // Amount of transfers aborted by timeout
+  uint32_t GetErrorCount() const { return _errors; }
+
+  // Max amount of bytes in a single transfer
+  static constexpr size_t MAX_TRANSFER = 128;
+
+private:
+  static void DmaIrqHandler();
+  void WaitComplete();
+  bool IsSchedulerRunning() const;
+
+  uint8_t _i2c_address;
+  int _i2c_port;
+  int _dma_channel = -1;
+
+  // The task waiting for the transfer completion
+  volatile TaskHandle_t _waiting_task = nullptr;
+  bool _in_flight = false;
+  bool _target_set = false;
+
+  // Amount of transfers aborted by timeout
+  uint32_t _errors = 0;
+
+  // The DMA writes 16-bit words into IC_DATA_CMD:
+  // the data byte in the low bits plus the STOP flag on the last one
+  uint16_t _words[MAX_TRANSFER];
+
+  // Only one transmitter owns the DMA interrupt
+  static I2CDmaTransmitter *_instance;
+};
@@ -3,6 +3,12 @@
     This class handles the piezo speaker operations such as playing sounds,
     generating tones, and controlling the speaker state.
     It uses FreeRTOS for task management and event handling.
+    The melodies are played by a sequencer: the sound task only starts
+    one, the next notes are programmed into the PWM slice from a timer
+    alarm callback, so the task is free for the next command at once.
+    A new melody replaces the one which plays unless that one has
+    a higher priority, so a beep does not cut the alarm short;
+    StopAlarm silences the alarm melody only.
 */
 
 #include "FreeRTOS.h"
@@ -10,78 +16,238 @@
 
 #include "pico/stdlib.h"
 #include "hardware/pwm.h"
-#include "hardware/clocks.h"
 
 #include "PiezoSound.hpp"
 
-#define NOTE_C4  262
-#define NOTE_D4  294
-#define NOTE_E4  330
-#define NOTE_F4  349
-#define NOTE_G4  392
-#define NOTE_A4  440
-#define NOTE_B4  494
-#define NOTE_C5  523
-#define NOTE_G5  784
+#ifdef SYS_CLK_HZ
+static constexpr uint32_t SoundClockHz = SYS_CLK_HZ;
+#else
+static constexpr uint32_t SoundClockHz = 150000000; // The RP2350 default
+#endif
 
+// MIDI note numbers
+#define NOTE_G3  55
+#define NOTE_C4  60
+#define NOTE_D4  62
+#define NOTE_E4  64
+#define NOTE_F4  65
+#define NOTE_G4  67
+#define NOTE_A4  69
+#define NOTE_B4  71
+#define NOTE_C5  72
+#define NOTE_G5  79
+#define NOTE_B5  83
+#define NOTE_D6  86
+#define NOTE_B6  95
+
+// The PWM settings of the notes from C3 to C8, computed at compile time
+// for the system clock. All the notes share one divider, the lowest note
+// just fits the 16 bit counter with it, so a note is only its wrap and
+// the pitch stays within a cent; a note change writes the TOP and the
+// CC register, both latched at the end of a period.
+struct NoteTable {
+    static constexpr uint8_t FirstNote = 48;  // C3
+    static constexpr uint8_t LastNote = 108;  // C8
+    static constexpr int Count = LastNote - FirstNote + 1;
+
+    uint16_t divider;   // 8.4 fixed point, as the DIV register
+    uint16_t wrap[Count];
+
+    constexpr NoteTable() : divider(0), wrap() {
+        constexpr double semitone = 1.0594630943592953; // 2^(1/12)
+
+        // Up and down from A4, as std::pow is not constexpr
+        double frequency[Count] = {};
+        frequency[69 - FirstNote] = 440.0;
+        for (int i = 69 - FirstNote + 1; i < Count; i++) {
+            frequency[i] = frequency[i - 1] * semitone;
+        }
+        for (int i = 69 - FirstNote - 1; i >= 0; i--) {
+            frequency[i] = frequency[i + 1] / semitone;
+        }
+
+        // The smallest divider which keeps the lowest note in range
+        double lowest = SoundClockHz * 16.0 / (65536.0 * frequency[0]);
+        divider = static_cast<uint16_t>(lowest);
+        if (divider < lowest) {
+            divider++;
+        }
+
+        for (int i = 0; i < Count; i++) {
+            double period = SoundClockHz * 16.0 / (divider * frequency[i]);
+            wrap[i] = static_cast<uint16_t>(period + 0.5) - 1;
+        }
+    }
+};
+
+static constexpr NoteTable Notes;
+
+static_assert(Notes.divider >= 16 && Notes.divider < 256 * 16, "The divider does not fit the DIV register");
 
 static const MelodyNote cuckooMelody[] = {
-    { 784, 300 }, // G5
-    {   0, 100 },
-    { 784, 300 }, // G5
-    {   0, 100 }
+    { NOTE_G5, 30 },
+    {       0, 10 },
+    { NOTE_G5, 30 },
+    {       0, 10 }
 };
 
 static const MelodyNote hatikvahEnding[] = {
-    { NOTE_E4, 250 },
-    { NOTE_G4, 500 },
-    { NOTE_F4, 250 },
-    { NOTE_F4, 250 },
-    { NOTE_E4, 500 },
-    { NOTE_E4, 250 },
-    { NOTE_E4, 250 },
-    { NOTE_F4, 250 },
-    { NOTE_F4, 250 },
-    { NOTE_F4, 250 },
-    { NOTE_G4, 250 },
-    { NOTE_C4, 750 }
+    { NOTE_E4, 25 },
+    { NOTE_G4, 50 },
+    { NOTE_F4, 25 },
+    { NOTE_F4, 25 },
+    { NOTE_E4, 50 },
+    { NOTE_E4, 25 },
+    { NOTE_E4, 25 },
+    { NOTE_F4, 25 },
+    { NOTE_F4, 25 },
+    { NOTE_F4, 25 },
+    { NOTE_G4, 25 },
+    { NOTE_C4, 75 }
+};
+
+static const MelodyNote menuBeep[] = {
+    { NOTE_B5, 5 }
+};
+
+static const MelodyNote alarmStart[] = {
+    { NOTE_B5, 10 },
+    {       0, 10 },
+    { NOTE_D6, 10 },
+    {       0, 10 }
 };
 
+// A chromatic run from G3 to B6, 50 ms each
+struct SweepNotes {
+    static constexpr int Count = NOTE_B6 - NOTE_G3 + 1;
+    MelodyNote notes[Count];
+
+    constexpr SweepNotes() : notes() {
+        for (int i = 0; i < Count; i++) {
+            notes[i] = { static_cast<uint8_t>(NOTE_G3 + i), 5 };
+        }
+    }
+};
+
+static constexpr SweepNotes sweepNotes;
+
+#define MELODY_LENGTH(notes) static_cast<uint8_t>(sizeof(notes) / sizeof(MelodyNote))
+
+// The beep is the least important, the alarm the most
+static const Melody MenuBeepMelody = { menuBeep, MELODY_LENGTH(menuBeep), 1, 0, 0 };
+static const Melody AlarmStartMelody = { alarmStart, MELODY_LENGTH(alarmStart), 10, 0, 2 }; // About 4 s
+static const Melody CuckooMelody = { cuckooMelody, MELODY_LENGTH(cuckooMelody), 1, 20, 1 };
+static const Melody HatikvahMelody = { hatikvahEnding, MELODY_LENGTH(hatikvahEnding), 1, 20, 1 };
+static const Melody SweepMelody = { sweepNotes.notes, SweepNotes::Count, 1, 0, 1 };
+
 PiezoSound::PiezoSound(uint8_t pin) : pin(pin)
 {
+    slice = pwm_gpio_to_slice_num(pin);
+    channel = pwm_gpio_to_channel(pin);
+
+    // The divider is the same for all the notes, it is set once
+    pwm_config cfg = pwm_get_default_config();
+    pwm_config_set_clkdiv_int_frac(&cfg, Notes.divider >> 4, Notes.divider & 0xF);
+    pwm_init(slice, &cfg, false);
+
     queue = xQueueCreate(8, sizeof(SoundCommand));
     xTaskCreate(TaskFunc, "SoundTask", 256, this, 1, nullptr);
 }
 
-void PiezoSound::PlayTone(uint frequency, uint duration_ms) {
+void PiezoSound::SetNote(uint8_t note) {
+    if (note < NoteTable::FirstNote || note > NoteTable::LastNote) {
+        pwm_set_chan_level(slice, channel, 0); // A pause, the slice keeps running
+        return;
+    }
+
+    // The slice is not stopped, so the notes follow with no gap
+    uint16_t wrap = Notes.wrap[note - NoteTable::FirstNote];
+    pwm_set_wrap(slice, wrap);
+    pwm_set_chan_level(slice, channel, (wrap + 1) / 2); // 50% duty
+}
+
+void PiezoSound::Silence() {
+    pwm_set_enabled(slice, false);
+    gpio_set_function(pin, GPIO_FUNC_SIO);
+    gpio_set_dir(pin, GPIO_OUT);
+    gpio_put(pin, 0);
+    playing = false;
+}
+
+void PiezoSound::StartMelody(const Melody& next) {
+    if (playing && melody != nullptr && melody->priority > next.priority) {
+        return; // The melody which plays is more important
+    }
+
+    StopMelody(); // Replaces the melody which plays
+    if (next.count == 0) {
+        return;
+    }
+
+    melody = &next;
+    noteIndex = 0;
+    playsLeft = next.plays;
+    inGap = false;
+    playing = true;
+
     gpio_set_function(pin, GPIO_FUNC_PWM);
-    uint slice = pwm_gpio_to_slice_num(pin);
-    uint channel = pwm_gpio_to_channel(pin);
+    int64_t durationUs = PlayNote(next.notes[0]);
+    pwm_set_enabled(slice, true);
+
+    alarmId = add_alarm_in_us(durationUs, AlarmCallback, this, true);
+    if (alarmId <= 0) {
+        Silence(); // No free alarm
+    }
+}
 
-    uint sys_clock = clock_get_hz(clk_sys); // 125 MHz typically
+void PiezoSound::StopMelody() {
+    // Once cancelled the callback does not run again,
+    // so the state is the task's until the next alarm
+    if (alarmId > 0) {
+        cancel_alarm(alarmId);
+        alarmId = 0;
+    }
+    if (melody != nullptr) {
+        Silence();
+        melody = nullptr;
+    }
+}
 
-    // Calculate initial top assuming clkdiv = 1.0
-    float clkdiv = 1.0f;
-    uint top = sys_clock / frequency;
+int64_t PiezoSound::AlarmCallback(alarm_id_t /*id*/, void* user_data) {
+    return static_cast<PiezoSound*>(user_data)->AdvanceMelody();
+}
 
-    // If top is too large, scale clkdiv so top fits in 16-bit range
-    if (top > 65535) {
-        clkdiv = (float)top / 65535.0f;
-        top = 65535;
+int64_t PiezoSound::AdvanceMelody() {
+    // A positive result reschedules from the time the alarm was due,
+    // so the latency of the interrupt does not add up over the melody
+    const MelodyNote& note = melody->notes[noteIndex];
+    if (!inGap && melody->gapMs > 0 && note.length * MelodyNote::UnitMs > melody->gapMs) {
+        inGap = true;
+        SetNote(0);
+        return melody->gapMs * 1000;
     }
+    inGap = false;
 
-    pwm_config cfg = pwm_get_default_config();
-    pwm_config_set_clkdiv(&cfg, clkdiv);
-    pwm_config_set_wrap(&cfg, top);
-    pwm_init(slice, &cfg, true);
+    if (++noteIndex >= melody->count) {
+        noteIndex = 0;
+        if (playsLeft > 0 && --playsLeft == 0) {
+            Silence();
+            return 0; // Done, the alarm is freed
+        }
+    }
 
-    pwm_set_chan_level(slice, channel, top / 2); // 50% duty
-    vTaskDelay(pdMS_TO_TICKS(duration_ms));
+    return PlayNote(melody->notes[noteIndex]);
+}
 
-    pwm_set_enabled(slice, false);
-    gpio_set_function(pin, GPIO_FUNC_SIO);
-    gpio_set_dir(pin, GPIO_OUT);
-    gpio_put(pin, 0);
+int64_t PiezoSound::PlayNote(const MelodyNote& note) {
+    SetNote(note.note);
+
+    uint32_t durationMs = note.length * MelodyNote::UnitMs;
+    if (melody->gapMs > 0 && durationMs > melody->gapMs) {
+        durationMs -= melody->gapMs;
+    }
+    // A zero would end the melody
+    return (durationMs > 0) ? durationMs * 1000 : 1000;
 }
 
 void PiezoSound::EnqueeCommand(SoundCommand command)
@@ -104,58 +270,29 @@ void PiezoSound::TaskFunc(void* param)
 void PiezoSound::PlaySequence(SoundCommand command) {
     switch (command) {
         case SoundCommand::MenuBeep:
-            PlayTone(1000, 50);
+            StartMelody(MenuBeepMelody);
             break;
 
         case SoundCommand::AlarmStart:
-            for (int i = 0; i < 10; ++i) {
-                PlayTone(1000, 100);
-                vTaskDelay(pdMS_TO_TICKS(100));
-                PlayTone(1200, 100);
-                vTaskDelay(pdMS_TO_TICKS(100));
-            }
+            StartMelody(AlarmStartMelody);
             break;
 
         case SoundCommand::HourlyCuckoo:
-            PlayMelody(cuckooMelody, sizeof(cuckooMelody) / sizeof(MelodyNote));
+            StartMelody(CuckooMelody);
             break;
 
         case SoundCommand::Hatikvah:
-            PlayMelody(hatikvahEnding, sizeof(hatikvahEnding) / sizeof(MelodyNote));
+            StartMelody(HatikvahMelody);
             break;
 
         case SoundCommand::Sweep:
-            {
-                const int start_freq = 200;   // Start of sweep (Hz)
-                const int end_freq = 2000;    // End of sweep (Hz)
-                const int step = 50;          // Hz step
-                const int duration = 50;      // ms per tone
-
-                for (int freq = start_freq; freq <= end_freq; freq += step)
-                {
-                    PlayTone(freq, duration);
-                    vTaskDelay(pdMS_TO_TICKS(10)); // small pause for smoothness
-                }
-            }
+            StartMelody(SweepMelody);
             break;
-    }
-}
-
-void PiezoSound::PlayMelody(const MelodyNote* notes, size_t length)
-{
-    for (size_t i = 0; i < length; ++i)
-    {
-        if (notes[i].frequency > 0)
-        {
-            PlayTone(notes[i].frequency, notes[i].duration_ms);
-        }
-        else
-        {
-            // Pause
-            vTaskDelay(pdMS_TO_TICKS(notes[i].duration_ms));
-        }
 
-        // Optional: small pause between notes
-        vTaskDelay(pdMS_TO_TICKS(20));
+        case SoundCommand::StopAlarm:
+            if (melody == &AlarmStartMelody) {
+                StopMelody();
+            }
+            break;
     }
 }
@@ -3,11 +3,20 @@
     This class handles the piezo speaker operations such as playing sounds,
     generating tones, and controlling the speaker state.
     It uses FreeRTOS for task management and event handling.
+    The melodies are played by a sequencer: the sound task only starts
+    one, the next notes are programmed into the PWM slice from a timer
+    alarm callback, so the task is free for the next command at once.
+    The PWM settings of the notes are computed at compile time, a note
+    change writes two registers with no math.
+    A new melody replaces the one which plays unless that one has
+    a higher priority, so a beep does not cut the alarm short;
+    StopAlarm silences the alarm melody only.
 */
 
 #pragma once
 
 #include <stdint.h>
+#include "pico/time.h"
 #include "queue.h"
 
 enum class SoundCommand {
@@ -16,11 +25,25 @@ enum class SoundCommand {
     MenuBeep,
     AlarmStart,
     HourlyCuckoo,
+    StopAlarm,
 };
 
+// Two bytes a note, the melodies stay small in flash
 struct MelodyNote {
-    uint16_t frequency; // 0 = pause
-    uint16_t duration_ms;
+    static constexpr uint32_t UnitMs = 10;
+
+    uint8_t note;   // MIDI note number, C3 (48) to C8 (108); 0 = pause
+    uint8_t length; // In units of UnitMs
+};
+
+// The notes follow each other with no gap, unless gapMs silences
+// the end of every note to separate repeated notes
+struct Melody {
+    const MelodyNote* notes;
+    uint8_t count;
+    uint8_t plays;  // Times the notes are played, 0 until stopped
+    uint8_t gapMs;  // Taken from the duration of the notes longer than it
+    uint8_t priority; // A melody is not replaced by one of a lower priority
 };
 
 class PiezoSound {
@@ -44,14 +67,40 @@ public:
         EnqueeCommand(SoundCommand::Hatikvah);
     }
 
+    // Silence the alarm melody, also in the middle of it;
+    // any other melody plays on
+    void StopAlarm() {
+        EnqueeCommand(SoundCommand::StopAlarm);
+    }
+
+    bool IsPlaying() const { return playing; }
+
 private:
     void EnqueeCommand(SoundCommand command);
     static void TaskFunc(void* param);
 
-    void PlayTone(uint frequency, uint duration_ms);
     void PlaySequence(SoundCommand command);
-    void PlayMelody(const MelodyNote* notes, size_t length);
+    void StartMelody(const Melody& melody);
+    void StopMelody();
+
+    // Run in the interrupt of the timer alarm
+    static int64_t AlarmCallback(alarm_id_t id, void* user_data);
+    int64_t AdvanceMelody();
+    int64_t PlayNote(const MelodyNote& note);
+    void SetNote(uint8_t note);
+    void Silence();
 
     QueueHandle_t queue;
     uint8_t pin;
+    uint slice;
+    uint channel;
+
+    // Set by the sound task while no alarm is pending,
+    // then changed only by the alarm callback
+    const Melody* melody = nullptr;
+    uint8_t noteIndex = 0;
+    uint8_t playsLeft = 0;
+    bool inGap = false;
+    volatile bool playing = false;
+    alarm_id_t alarmId = 0;
 };
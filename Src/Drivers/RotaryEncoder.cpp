@@ -2,67 +2,385 @@
   * Rotary Encoder Driver for Raspberry Pi Pico
   * This implementation uses FreeRTOS for task management and event handling.
   * It captures rotation and button press events from a rotary encoder.
+  * Every edge of L or R is decoded in the interrupt, so no step is
+  * lost however fast the knob turns. A detent is one full quadrature
+  * cycle from the rest state (both pins high) back to it; contact
+  * bounce moves the state back and forth and cancels itself out.
+  * The interrupt stamps the events with their time, so the step
+  * multiplier and the gestures do not depend on when the task runs.
 */
 
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include <climits>
+
 #include "RotaryEncoder.hpp"
 
-RotaryEncoder::RotaryEncoder(uint gpioL, uint gpioR, uint gpioBtn)
-    : pinL(gpioL), pinR(gpioR), pinBtn(gpioBtn),
-      lastL(true), lastR(true), lastBtn(true), eventQueue(nullptr),
-      lastRotationTime(get_absolute_time()),
-      lastButtonTime(get_absolute_time()) {}
+// Quarter step for each (previous state << 2 | new state), 0 for no
+// change and for the invalid jumps over a state. Turning right L falls
+// first: 11 -> 01 -> 00 -> 10 -> 11, turning left R does.
+static const int8_t QuadratureTable[16] = {
+     0, -1, +1,  0,
+    +1,  0,  0, -1,
+    -1,  0,  0, +1,
+     0, +1, -1,  0,
+};
+
+static constexpr uint8_t QuadRest = 0x3;
+
+RotaryEncoder* RotaryEncoder::instance = nullptr;
+
+RotaryEncoder::RotaryEncoder(uint gpioL, uint gpioR, uint gpioBtn, EncoderDecoder decoder)
+    : pinL(gpioL), pinR(gpioR), pinBtn(gpioBtn), decoder(decoder),
+      quadState(QuadRest), quadSteps(0), lastButtonEdgeUs(0), buttonSettling(false),
+      ringHead(0), ringTail(0), dropped(0),
+      pioQuad(0), pioButton(0), smQuad(-1), smButton(-1), detentCount(0),
+      buttonDown(false), pressConsumed(false), clickPending(false),
+      downUs(0), clickDownUs(0), clickUpUs(0), nextRepeatUs(0),
+      lastDirection(0), lastRotationUs(0),
+      overflow(), overflowCount(0), queueDropped(0), merged(0),
+      task(nullptr), eventQueue(nullptr) {}
 
 void RotaryEncoder::Init() {
+    eventQueue = xQueueCreate(10, sizeof(EncoderEvent));
+    xTaskCreate(EncoderTask, "EncoderTask", 512, this, 1, &task);
+
+    if (decoder == EncoderDecoder::Pio) {
+        if (InitPio()) {
+            return;
+        }
+        decoder = EncoderDecoder::Gpio;
+    }
+
     gpio_init(pinL); gpio_set_dir(pinL, GPIO_IN); gpio_pull_up(pinL);
     gpio_init(pinR); gpio_set_dir(pinR, GPIO_IN); gpio_pull_up(pinR);
     gpio_init(pinBtn); gpio_set_dir(pinBtn, GPIO_IN); gpio_pull_up(pinBtn);
 
-    eventQueue = xQueueCreate(10, sizeof(EncoderEvent));
-    xTaskCreate(EncoderTask, "EncoderTask", 512, this, 1, nullptr);
+    quadState = (gpio_get(pinL) << 1) | gpio_get(pinR);
+    lastButtonEdgeUs = time_us_32();
+
+    // The task exists before the first interrupt can notify it
+    instance = this;
+    const uint32_t edges = GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE;
+    gpio_add_raw_irq_handler_masked((1u << pinL) | (1u << pinR) | (1u << pinBtn),
+                                    GpioIrqHandler);
+    gpio_set_irq_enabled(pinL, edges, true);
+    gpio_set_irq_enabled(pinR, edges, true);
+    gpio_set_irq_enabled(pinBtn, edges, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
 }
 
 QueueHandle_t RotaryEncoder::GetEventQueue() const {
     return eventQueue;
 }
 
+void RotaryEncoder::SetAcceleration(const EncoderAcceleration& curve) {
+    taskENTER_CRITICAL();
+    acceleration.CopyFrom(curve);
+    taskEXIT_CRITICAL();
+}
+
+void RotaryEncoder::SetGestures(const EncoderGestures& timing) {
+    taskENTER_CRITICAL();
+    gestures.CopyFrom(timing);
+    taskEXIT_CRITICAL();
+}
+
+void RotaryEncoder::GpioIrqHandler() {
+    RotaryEncoder *self = instance;
+    if (self == nullptr) {
+        return;
+    }
+
+    if (self->HandleEdges(time_us_32())) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(self->task, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+}
+
+bool RotaryEncoder::HandleEdges(uint32_t now) {
+    uint32_t head = ringHead;
+
+    // The handler is shared with the other GPIO interrupts
+    uint32_t rotation = gpio_get_irq_event_mask(pinL) | gpio_get_irq_event_mask(pinR);
+    uint32_t button = gpio_get_irq_event_mask(pinBtn);
+
+    if (rotation != 0) {
+        gpio_acknowledge_irq(pinL, gpio_get_irq_event_mask(pinL));
+        gpio_acknowledge_irq(pinR, gpio_get_irq_event_mask(pinR));
+
+        // The levels are read after the acknowledge,
+        // an edge coming in between raises the interrupt again
+        uint8_t state = (gpio_get(pinL) << 1) | gpio_get(pinR);
+        quadSteps += QuadratureTable[(quadState << 2) | state];
+        quadState = state;
+
+        if (state == QuadRest) {
+            // Half a cycle is enough, an edge may be missed at high speed
+            if (quadSteps >= 2) {
+                PushEvent(RingEvent::Rotation, +1, now);
+            } else if (quadSteps <= -2) {
+                PushEvent(RingEvent::Rotation, -1, now);
+            }
+            quadSteps = 0;
+        }
+    }
+
+    if (button != 0) {
+        gpio_acknowledge_irq(pinBtn, button);
+
+        // An edge counts when the pin was quiet for the debounce time
+        // before it, so the bounces of both edges are ignored. The level
+        // read here may be a bounce, the task reads it again once the
+        // pin is quiet and corrects a missed edge
+        bool stable = (now - lastButtonEdgeUs) > BUTTON_DEBOUNCE_US;
+        lastButtonEdgeUs = now;
+        buttonSettling = true;
+        if (stable) {
+            PushButtonEdge(!gpio_get(pinBtn), now);
+        }
+        return true; // The task sets the deadline of the settled read
+    }
+
+    return ringHead != head;
+}
+
+void RotaryEncoder::PushButtonEdge(bool down, uint32_t now) {
+    PushEvent(down ? RingEvent::ButtonDown : RingEvent::ButtonUp, 0, now);
+}
+
+void RotaryEncoder::PushEvent(RingEvent type, int8_t delta, uint32_t now) {
+    uint32_t head = ringHead;
+    if (head - ringTail >= RING_SIZE) {
+        dropped++;
+        return;
+    }
+
+    ring[head % RING_SIZE].timeUs = now;
+    ring[head % RING_SIZE].type = type;
+    ring[head % RING_SIZE].delta = delta;
+    ringHead = head + 1; // Publish after the slot is written
+}
+
 void RotaryEncoder::EncoderTask(void *param) {
     RotaryEncoder *self = static_cast<RotaryEncoder*>(param);
     while (true) {
-        self->ProcessInput();
-        vTaskDelay(pdMS_TO_TICKS(2));
-    }
-}
-
-void RotaryEncoder::ProcessInput() {
-    bool spinL = gpio_get(pinL) == 0;
-    bool spinR = gpio_get(pinR) == 0;
-    bool btn = gpio_get(pinBtn) == 0;
-
-    // Rotation debounce
-    if (spinL != lastL || spinR != lastR) {
-        if (lastL && !spinL) {
-            absolute_time_t now = get_absolute_time();
-            if (absolute_time_diff_us(lastRotationTime, now) > ROTATION_DEBOUNCE_US) {
-                EncoderEvent evt;
-                evt.type = spinR ? 
-                    EncoderEventType::RotatedL : 
-                    EncoderEventType::RotatedR;
-                xQueueSend(eventQueue, &evt, 0);
-                lastRotationTime = now;
-            }
+        // Woken by the interrupt or by the next gesture deadline;
+        // with events held back the queue is retried now and then
+        TickType_t wait = self->TicksToNextDeadline(time_us_32());
+        if (self->overflowCount > 0 && wait > pdMS_TO_TICKS(10)) {
+            wait = pdMS_TO_TICKS(10);
         }
-        lastL = spinL;
-        lastR = spinR;
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        self->FlushOverflow();
+        self->DrainEvents();
+        self->SettleButton(time_us_32());
+        self->UpdateGestures(time_us_32());
     }
+}
+
+void RotaryEncoder::DrainEvents() {
+    uint32_t tail = ringTail;
+    while (tail != ringHead) {
+        const volatile RingEntry& entry = ring[tail % RING_SIZE];
+        uint32_t timeUs = entry.timeUs;
 
-    // Button debounce
-    if (!lastBtn && btn) {
-        absolute_time_t now = get_absolute_time();
-        if (absolute_time_diff_us(lastButtonTime, now) > BUTTON_DEBOUNCE_US) {
-            EncoderEvent evt{EncoderEventType::Pressed};
-            xQueueSend(eventQueue, &evt, 0);
-            lastButtonTime = now;
+        // The deadlines which passed before the entry come first
+        UpdateGestures(timeUs);
+        switch (entry.type) {
+            case RingEvent::Rotation:
+                SendEvent(EncoderEventType::Rotated, entry.delta, timeUs);
+                break;
+            case RingEvent::ButtonDown:
+                HandleButton(true, timeUs);
+                break;
+            case RingEvent::ButtonUp:
+                HandleButton(false, timeUs);
+                break;
         }
+        tail++;
+        ringTail = tail; // Frees the slot for the interrupt
+    }
+}
+
+void RotaryEncoder::SendEvent(EncoderEventType type, int delta, uint32_t timeUs) {
+    EncoderEvent evt;
+    evt.type = type;
+    evt.delta = delta;
+    evt.steps = delta;
+    evt.timeUs = timeUs;
+
+    if (type == EncoderEventType::Rotated) {
+        // The speed counts in one direction only, a reversal starts slow
+        if (delta == lastDirection) {
+            taskENTER_CRITICAL();
+            evt.steps = delta * acceleration.StepsFor(timeUs - lastRotationUs);
+            taskEXIT_CRITICAL();
+        }
+        lastDirection = delta;
+        lastRotationUs = timeUs;
+    }
+
+    QueueEvent(evt);
+}
+
+// Positive if a is after b, also across the wrap of the time
+static int32_t TimeDiffUs(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b);
+}
+
+void RotaryEncoder::HandleButton(bool down, uint32_t timeUs) {
+    if (down == buttonDown) {
+        return; // Lost an edge, take the level as it is
+    }
+    buttonDown = down;
+
+    taskENTER_CRITICAL();
+    EncoderGestures timing = gestures;
+    taskEXIT_CRITICAL();
+
+    if (down) {
+        downUs = timeUs;
+        pressConsumed = false;
+
+        // A second press soon after a click makes a double click at once
+        if (clickPending && TimeDiffUs(timeUs, clickUpUs) <= static_cast<int32_t>(timing.doubleClickMs * 1000)) {
+            clickPending = false;
+            pressConsumed = true;
+            SendEvent(EncoderEventType::DoubleClick, 0, clickDownUs);
+        }
+        return;
+    }
+
+    if (pressConsumed) {
+        return; // The release of a long press or of a double click
+    }
+
+    if (timing.doubleClickMs == 0) {
+        SendEvent(EncoderEventType::Pressed, 0, downUs);
+        return;
+    }
+
+    // Wait if a second click comes
+    clickPending = true;
+    clickDownUs = downUs;
+    clickUpUs = timeUs;
+}
+
+void RotaryEncoder::UpdateGestures(uint32_t now) {
+    taskENTER_CRITICAL();
+    EncoderGestures timing = gestures;
+    taskEXIT_CRITICAL();
+
+    if (clickPending && TimeDiffUs(now, clickUpUs) > static_cast<int32_t>(timing.doubleClickMs * 1000)) {
+        clickPending = false;
+        SendEvent(EncoderEventType::Pressed, 0, clickDownUs);
+    }
+
+    if (!buttonDown) {
+        return;
+    }
+
+    if (!pressConsumed) {
+        if (TimeDiffUs(now, downUs) >= static_cast<int32_t>(timing.longPressMs * 1000)) {
+            pressConsumed = true;
+            clickPending = false; // A click before a long press stands alone
+            nextRepeatUs = downUs + (timing.longPressMs + timing.repeatMs) * 1000;
+            SendEvent(EncoderEventType::LongPress, 0, downUs);
+        }
+        return;
+    }
+
+    // Only a long press repeats, a double click is done on its press
+    bool longPress = TimeDiffUs(now, downUs) >= static_cast<int32_t>(timing.longPressMs * 1000);
+    while (longPress && timing.repeatMs > 0 && TimeDiffUs(now, nextRepeatUs) >= 0) {
+        SendEvent(EncoderEventType::HoldRepeat, 0, nextRepeatUs);
+        nextRepeatUs += timing.repeatMs * 1000;
+    }
+}
+
+void RotaryEncoder::SettleButton(uint32_t now) {
+    // The edges of the PIO decoder are debounced by the program
+    if (decoder != EncoderDecoder::Gpio) {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    uint32_t edgeUs = lastButtonEdgeUs;
+    bool settled = buttonSettling && TimeDiffUs(now, edgeUs) > static_cast<int32_t>(BUTTON_DEBOUNCE_US);
+    if (settled) {
+        buttonSettling = false;
+    }
+    taskEXIT_CRITICAL();
+
+    // A bounce read at the edge lost the edge, the level now is right
+    if (settled) {
+        bool down = !gpio_get(pinBtn);
+        if (down != buttonDown) {
+            HandleButton(down, edgeUs);
+        }
+    }
+}
+
+TickType_t RotaryEncoder::TicksToNextDeadline(uint32_t now) const {
+    EncoderGestures timing = gestures;
+    int32_t waitUs = INT32_MAX;
+
+    if (buttonSettling) {
+        waitUs = TimeDiffUs(lastButtonEdgeUs + BUTTON_DEBOUNCE_US + 1, now);
+    }
+
+    if (clickPending) {
+        int32_t untilClick = TimeDiffUs(clickUpUs + timing.doubleClickMs * 1000, now);
+        waitUs = (untilClick < waitUs) ? untilClick : waitUs;
+    }
+    if (buttonDown) {
+        int32_t untilLong = TimeDiffUs(downUs + timing.longPressMs * 1000, now);
+        if (!pressConsumed) {
+            waitUs = (untilLong < waitUs) ? untilLong : waitUs;
+        } else if (untilLong <= 0 && timing.repeatMs > 0) {
+            int32_t untilRepeat = TimeDiffUs(nextRepeatUs, now);
+            waitUs = (untilRepeat < waitUs) ? untilRepeat : waitUs;
+        }
+    }
+
+    if (waitUs == INT32_MAX) {
+        return portMAX_DELAY;
+    }
+    if (waitUs <= 0) {
+        return 0;
+    }
+    // Rounded up, a deadline is never checked early
+    return pdMS_TO_TICKS((waitUs + 999) / 1000) + 1;
+}
+
+void RotaryEncoder::QueueEvent(const EncoderEvent& evt) {
+    // The held back events go first, the order must be kept
+    if (FlushOverflow() && xQueueSend(eventQueue, &evt, 0) == pdTRUE) {
+        return;
+    }
+
+    // While the queue is full the rotations add up in the overflow
+    if (overflowCount > 0 && overflow[overflowCount - 1].Merge(evt)) {
+        merged++;
+    } else if (overflowCount < OVERFLOW_SIZE) {
+        overflow[overflowCount++] = evt;
+    } else {
+        queueDropped++;
+    }
+}
+
+bool RotaryEncoder::FlushOverflow() {
+    int sent = 0;
+    while (sent < overflowCount && xQueueSend(eventQueue, &overflow[sent], 0) == pdTRUE) {
+        sent++;
+    }
+
+    for (int i = sent; i < overflowCount; i++) {
+        overflow[i - sent] = overflow[i];
     }
-    lastBtn = btn;
+    overflowCount -= sent;
+    return overflowCount == 0;
 }
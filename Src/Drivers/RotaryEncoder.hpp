@@ -2,6 +2,20 @@
   * Rotary Encoder Driver for Raspberry Pi Pico
   * This implementation uses FreeRTOS for task management and event handling.
   * It captures rotation and button press events from a rotary encoder.
+  * The pins are watched by GPIO edge interrupts: the interrupt decodes
+  * the quadrature signal with a transition table and puts the events
+  * in a lock-free ring, the encoder task is woken only to move them
+  * to the event queue. Nothing runs while the knob is left alone.
+  * Alternatively two PIO state machines decode the knob and the button
+  * (QuadratureEncoder.pio), their FIFO interrupts put the detents
+  * and the button edges in the same ring.
+  * Each detent is timestamped; detents in quick succession carry a
+  * step multiplier, so a fast spin changes a value by more than one.
+  * A rotation carries a signed delta, so the rotations which pile up
+  * while the consumer is busy can be merged into one event.
+  * The button edges are timestamped in the same interrupt, the encoder
+  * task turns them into clicks, double clicks, long presses and the
+  * repeats of a held button.
 */
 
 #pragma once
@@ -13,32 +27,181 @@
 #include "task.h"
 
 enum class EncoderEventType {
-    RotatedR,
-    RotatedL,
-    Pressed
+    Rotated,
+    Pressed,        // A short click
+    DoubleClick,    // A second click soon after the first
+    LongPress,      // The button held down
+    HoldRepeat      // Repeated while the button stays held after a long press
 };
 
 struct EncoderEvent {
     EncoderEventType type;
+    int16_t delta;   // Detents of a rotation, positive to the right
+    int16_t steps;   // The delta with the acceleration applied
+    uint32_t timeUs; // When the first input of the event came
+
+    // Add a later rotation in the same direction to this one;
+    // the time stays the one of the first input
+    bool Merge(const EncoderEvent& next) {
+        if (type != EncoderEventType::Rotated || next.type != EncoderEventType::Rotated ||
+            (delta > 0) != (next.delta > 0)) {
+            return false;
+        }
+        delta += next.delta;
+        steps += next.steps;
+        return true;
+    }
+};
+
+// Timing of the button gestures
+struct EncoderGestures {
+    uint32_t longPressMs = 800;     // Held this long it is a long press
+    uint32_t doubleClickMs = 250;   // Most time from a release to the next press, 0 for no double clicks
+    uint32_t repeatMs = 200;        // Period of HoldRepeat after a long press, 0 for none
+
+    void CopyFrom(const EncoderGestures& other) {
+        *this = other;
+    }
+};
+
+struct EncoderStats {
+    uint32_t dropped = 0; // Events lost to a full ring or event queue
+    uint32_t merged = 0;  // Rotations merged while the event queue was full
+};
+
+// One stage of the acceleration curve: a detent which comes less than
+// maxIntervalUs after the previous one in the same direction is worth steps
+struct AccelerationStage {
+    uint32_t maxIntervalUs;
+    uint8_t steps;
+};
+
+// The acceleration curve, the stages are tried in order, the fastest first;
+// without stages every detent is one step
+struct EncoderAcceleration {
+    static constexpr int MaxStages = 4;
+    AccelerationStage stages[MaxStages] = {
+        {30000, 15},    // Faster than ~33 detents per second
+        {80000, 5},     // Faster than ~12 detents per second
+    };
+    int count = 2;
+
+    void CopyFrom(const EncoderAcceleration& other) {
+        *this = other;
+    }
+
+    uint8_t StepsFor(uint32_t intervalUs) const {
+        for (int i = 0; i < count; i++) {
+            if (intervalUs < stages[i].maxIntervalUs) {
+                return stages[i].steps;
+            }
+        }
+        return 1;
+    }
+};
+
+enum class EncoderDecoder {
+    Gpio,   // Edge interrupts decoded by the CPU
+    Pio     // PIO state machines, R must be the pin after L
 };
 
 class RotaryEncoder {
 public:
-    RotaryEncoder(uint gpioL, uint gpioR, uint gpioBtn);
+    RotaryEncoder(uint gpioL, uint gpioR, uint gpioBtn,
+                  EncoderDecoder decoder = EncoderDecoder::Gpio);
+
+    // Falls back to the GPIO decoder if no PIO can take the programs
     void Init();
     QueueHandle_t GetEventQueue() const;
 
+    // The decoder in use, Gpio after a fallback
+    EncoderDecoder GetDecoder() const { return decoder; }
+
+    void GetStats(EncoderStats& outStats) const {
+        outStats.dropped = dropped + queueDropped;
+        outStats.merged = merged;
+    }
+
+    void SetAcceleration(const EncoderAcceleration& curve);
+
+    // A click is reported once doubleClickMs passed without a second press
+    void SetGestures(const EncoderGestures& timing);
+
 private:
     uint pinL, pinR, pinBtn;
-    bool lastL, lastR, lastBtn;
+    EncoderDecoder decoder;
 
-    absolute_time_t lastRotationTime;
-    absolute_time_t lastButtonTime;
-    static constexpr uint ROTATION_DEBOUNCE_US = 5000;
+    // Quadrature state, bit 1 is L and bit 0 is R, a released pin reads 1
+    uint8_t quadState;
+    int8_t quadSteps;   // Quarter steps since the knob left the detent
+    volatile uint32_t lastButtonEdgeUs;
+    volatile bool buttonSettling; // The button pin moved and was not read after it settled
     static constexpr uint BUTTON_DEBOUNCE_US = 10000;
 
+    // Written by the interrupt only, read by the encoder task only
+    enum class RingEvent : uint8_t {
+        Rotation,   // delta is the direction
+        ButtonDown,
+        ButtonUp
+    };
+    struct RingEntry {
+        uint32_t timeUs;
+        RingEvent type;
+        int8_t delta;
+    };
+    static constexpr uint32_t RING_SIZE = 32; // A power of two
+    volatile RingEntry ring[RING_SIZE];
+    volatile uint32_t ringHead;
+    volatile uint32_t ringTail;
+    volatile uint32_t dropped;
+
+    static RotaryEncoder* instance;
+    static void GpioIrqHandler();
+    bool HandleEdges(uint32_t now);
+    void PushEvent(RingEvent type, int8_t delta, uint32_t now);
+    void PushButtonEdge(bool down, uint32_t now);
+
+    // The PIO decoder, see RotaryEncoderPio.cpp
+    bool InitPio();
+    static void PioIrqHandler();
+    bool HandlePioFifos(uint32_t now);
+    uint pioQuad, pioButton; // The programs do not fit in one PIO together
+    int smQuad, smButton;
+    uint32_t detentCount; // Quarter step count of the PIO at the last reported detent
+
     static void EncoderTask(void *param);
-    void ProcessInput();
+    void DrainEvents();
+    void SendEvent(EncoderEventType type, int delta, uint32_t timeUs);
+
+    // The gesture recognizer, run by the encoder task on the button edges
+    // and on its deadlines; the times are those of the interrupt
+    void HandleButton(bool down, uint32_t timeUs);
+    void UpdateGestures(uint32_t now);
+    void SettleButton(uint32_t now);
+    TickType_t TicksToNextDeadline(uint32_t now) const;
+    EncoderGestures gestures;
+    bool buttonDown;
+    bool pressConsumed;   // The press made a double click or a long press
+    bool clickPending;    // A click waits for the double click time to pass
+    uint32_t downUs;      // When the button went down last
+    uint32_t clickDownUs; // When the pending click went down
+    uint32_t clickUpUs;   // When the pending click was released
+    uint32_t nextRepeatUs;
+    void QueueEvent(const EncoderEvent& evt);
+    bool FlushOverflow();
+
+    EncoderAcceleration acceleration;
+    int lastDirection;
+    uint32_t lastRotationUs;
+
+    // The events which did not fit in the event queue, in order;
+    // a rotation is merged into the last one when it can be
+    static constexpr int OVERFLOW_SIZE = 4;
+    EncoderEvent overflow[OVERFLOW_SIZE];
+    int overflowCount;
+    uint32_t queueDropped;
+    uint32_t merged;
 
+    TaskHandle_t task;
     QueueHandle_t eventQueue;
 };
@@ -0,0 +1,147 @@
+/*
+  * Rotary Encoder Driver for Raspberry Pi Pico - the PIO decoder
+  * The quadrature_encoder state machine counts the quarter steps and
+  * pushes the count after each one, encoder_button pushes a word for
+  * every debounced press and release (QuadratureEncoder.pio). Together the
+  * programs do not fit in the 32 instructions of one PIO, so each is loaded
+  * into the first PIO with room for it. The RX FIFO interrupt handler
+  * takes the newest count and puts the whole detents since the last one
+  * and the button edges in the ring, stamped with the time of the
+  * interrupt, then wakes the encoder task. The count stays exact;
+  * the detents read at once share the time of the read.
+*/
+
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+
+#include "RotaryEncoder.hpp"
+#include "QuadratureEncoder.pio.h"
+
+// A detent is a full quadrature cycle
+static constexpr int32_t STEPS_PER_DETENT = 4;
+
+// The quadrature loop takes up to 10 cycles, so the pins are sampled
+// at 100 kHz or faster; the button program needs 100 kHz for its debounce
+static constexpr float QUAD_SM_HZ = 1000000.0f;
+static constexpr float BUTTON_SM_HZ = 100000.0f;
+
+// Load the program into the first PIO with room for it and a free state machine
+static bool LoadProgram(const pio_program_t *program, uint &pioIndex, int &sm, uint &offset) {
+    for (uint i = 0; i < NUM_PIOS; i++) {
+        PIO pio = pio_get_instance(i);
+        if (!pio_can_add_program(pio, program)) {
+            continue;
+        }
+
+        int claimed = pio_claim_unused_sm(pio, false);
+        if (claimed < 0) {
+            continue;
+        }
+
+        offset = pio_add_program(pio, program);
+        pioIndex = i;
+        sm = claimed;
+        return true;
+    }
+
+    return false;
+}
+
+static void EnableFifoIrq(PIO pio, int sm, irq_handler_t handler) {
+    pio_set_irqn_source_enabled(pio, 0, pio_get_rx_fifo_not_empty_interrupt_source(sm), true);
+
+    if (handler != nullptr) {
+        uint irqNum = pio_get_irq_num(pio, 0);
+        irq_add_shared_handler(irqNum, handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(irqNum, true);
+    }
+}
+
+bool RotaryEncoder::InitPio() {
+    if (pinR != pinL + 1) {
+        return false; // The program reads L and R with one IN
+    }
+
+    // The jump table of the quadrature program is at offset 0 (.origin)
+    uint quadOffset, buttonOffset;
+    if (!LoadProgram(&quadrature_encoder_program, pioQuad, smQuad, quadOffset)) {
+        return false;
+    }
+    if (!LoadProgram(&encoder_button_program, pioButton, smButton, buttonOffset)) {
+        PIO pio = pio_get_instance(pioQuad);
+        pio_remove_program(pio, &quadrature_encoder_program, quadOffset);
+        pio_sm_unclaim(pio, smQuad);
+        smQuad = -1;
+        return false;
+    }
+
+    PIO quadPio = pio_get_instance(pioQuad);
+    PIO buttonPio = pio_get_instance(pioButton);
+    float sysHz = static_cast<float>(clock_get_hz(clk_sys));
+    quadrature_encoder_program_init(quadPio, smQuad, quadOffset, pinL, sysHz / QUAD_SM_HZ);
+    encoder_button_program_init(buttonPio, smButton, buttonOffset, pinBtn, sysHz / BUTTON_SM_HZ);
+
+    // The task exists before the first interrupt can notify it
+    instance = this;
+
+    // A PIO which has both state machines gets the handler once
+    EnableFifoIrq(quadPio, smQuad, PioIrqHandler);
+    EnableFifoIrq(buttonPio, smButton, (pioButton != pioQuad) ? PioIrqHandler : nullptr);
+    return true;
+}
+
+void RotaryEncoder::PioIrqHandler() {
+    RotaryEncoder *self = instance;
+    if (self == nullptr || self->decoder != EncoderDecoder::Pio) {
+        return;
+    }
+
+    if (pio_sm_is_rx_fifo_empty(pio_get_instance(self->pioQuad), self->smQuad) &&
+        pio_sm_is_rx_fifo_empty(pio_get_instance(self->pioButton), self->smButton)) {
+        return; // Not our state machines, the handler is shared
+    }
+
+    self->HandlePioFifos(time_us_32());
+
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(self->task, &higherPriorityTaskWoken);
+    portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+// Empties both FIFOs, which clears the interrupt sources
+bool RotaryEncoder::HandlePioFifos(uint32_t now) {
+    PIO quadPio = pio_get_instance(pioQuad);
+    PIO buttonPio = pio_get_instance(pioButton);
+    bool quadPushed = false;
+    uint32_t count = 0;
+
+    while (!pio_sm_is_rx_fifo_empty(quadPio, smQuad)) {
+        count = pio_sm_get(quadPio, smQuad);
+        quadPushed = true;
+    }
+
+    if (quadPushed) {
+        // Whole detents only, the rest is reported when the knob gets there
+        int32_t steps = static_cast<int32_t>(count - detentCount);
+        while (steps >= STEPS_PER_DETENT) {
+            PushEvent(RingEvent::Rotation, +1, now);
+            detentCount += STEPS_PER_DETENT;
+            steps -= STEPS_PER_DETENT;
+        }
+        while (steps <= -STEPS_PER_DETENT) {
+            PushEvent(RingEvent::Rotation, -1, now);
+            detentCount -= STEPS_PER_DETENT;
+            steps += STEPS_PER_DETENT;
+        }
+    }
+
+    // The button program pushes 0 for a press and 1 for a release
+    bool buttonPushed = false;
+    while (!pio_sm_is_rx_fifo_empty(buttonPio, smButton)) {
+        PushButtonEdge(pio_sm_get(buttonPio, smButton) == 0, now);
+        buttonPushed = true;
+    }
+
+    return quadPushed || buttonPushed;
+}
@@ -17,5 +17,6 @@ target_link_libraries(freertos_config
 	hardware_i2c
 	hardware_pwm
 	hardware_adc
+	hardware_dma
 	pico_stdlib
 	)
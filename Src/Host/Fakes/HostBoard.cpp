@@ -0,0 +1,515 @@
+/*
+  * HostBoard - the fake peripherals of the host build
+    * Backs the GPIO, ADC, PWM and I2C shims with plain memory, so the
+    * real drivers run unchanged and their effect can be inspected:
+    *   GPIO - output levels, inputs driven from the host, pulls, and
+    *          the edge interrupts, run on the thread changing the input,
+    *   ADC  - conversion results set from the host (the temperature sensor),
+    *   PWM  - the slice configuration, from which the tone is derived,
+    *   I2C  - a PCF8574 expander with an HD44780 controller behind it,
+    *          decoded from the nibble stream the real LCD driver sends.
+*/
+
+#include <string.h>
+
+#include <mutex>
+#include <vector>
+
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/i2c.h"
+#include "hardware/pwm.h"
+
+#include "HostBoard.hpp"
+
+struct i2c_inst {
+    int index;
+};
+
+static i2c_inst i2cInstances[2] = {{0}, {1}};
+i2c_inst_t* const i2c0 = &i2cInstances[0];
+i2c_inst_t* const i2c1 = &i2cInstances[1];
+
+namespace {
+
+// PCF8574 port bits, as wired on the usual LCD backpacks
+constexpr uint8_t PortRS = 0x01;
+constexpr uint8_t PortRW = 0x02;
+constexpr uint8_t PortEN = 0x04;
+
+struct Pin {
+    bool output = false;
+    bool level = false;
+    int pull = 0;      // 1 up, -1 down
+    int driven = -1;   // Level driven from the host, -1 if none
+    uint32_t toggles = 0;
+    uint32_t irqEnabled = 0; // GPIO_IRQ_EDGE_* events which interrupt
+    uint32_t irqEvents = 0;  // Events not acknowledged yet
+};
+
+struct GpioIrqHandler {
+    uint32_t mask;
+    irq_handler_t handler;
+};
+
+// HD44780 controller model, fed with the PCF8574 port writes
+struct Lcd {
+    uint8_t port = 0;
+    bool fourBit = false;
+    bool haveHigh = false;
+    uint8_t high = 0;
+    bool cgMode = false;
+    uint8_t address = 0;
+    uint8_t ddram[128];
+    uint8_t cgram[64];
+    uint32_t version = 0;
+
+    Lcd() {
+        memset(ddram, ' ', sizeof(ddram));
+        memset(cgram, 0, sizeof(cgram));
+    }
+
+    void Write(uint8_t value) {
+        // The controller latches the nibble on the falling edge of E
+        bool falling = (port & PortEN) && !(value & PortEN);
+        uint8_t latched = port;
+        port = value;
+
+        if (!falling || (latched & PortRW)) {
+            return; // Busy flag reads do not change anything
+        }
+
+        uint8_t nibble = latched & 0xF0;
+        bool data = (latched & PortRS) != 0;
+
+        if (!fourBit) {
+            // Only the function set nibbles come in the 8-bit mode
+            if (nibble == 0x20) {
+                fourBit = true;
+            }
+            return;
+        }
+
+        if (!haveHigh) {
+            high = nibble;
+            haveHigh = true;
+            return;
+        }
+        haveHigh = false;
+        Execute(high | (nibble >> 4), data);
+    }
+
+    void Execute(uint8_t value, bool data) {
+        if (data) {
+            if (cgMode) {
+                cgram[address & 0x3F] = value;
+            } else {
+                ddram[address & 0x7F] = value;
+                version++;
+            }
+            address++;
+            return;
+        }
+
+        if (value & 0x80) {
+            address = value & 0x7F;
+            cgMode = false;
+        } else if (value & 0x40) {
+            address = value & 0x3F;
+            cgMode = true;
+        } else if (value == 0x01) {
+            memset(ddram, ' ', sizeof(ddram));
+            address = 0;
+            cgMode = false;
+            version++;
+        } else if (value == 0x02) {
+            address = 0;
+            cgMode = false;
+        }
+    }
+};
+
+struct Board {
+    std::mutex lock;
+    Pin pins[HostBoard::Pins];
+    uint16_t adc[5] = {0, 0, 0, 0, 0};
+    uint adcInput = 0;
+    HostPwmSlice pwm[HostBoard::PwmSlices];
+    Lcd lcd;
+    uint32_t i2cBytes = 0;
+    std::vector<GpioIrqHandler> irqHandlers;
+    bool bankIrqEnabled = false;
+    std::mutex irqLock; // One interrupt at a time, as on the core
+};
+
+Board& TheBoard()
+{
+    static Board board;
+    return board;
+}
+
+bool PinLevel(const Pin& pin)
+{
+    if (pin.output) {
+        return pin.level;
+    }
+    if (pin.driven >= 0) {
+        return pin.driven != 0;
+    }
+    return pin.pull > 0;
+}
+
+void PutPin(Pin& pin, bool value)
+{
+    if (pin.level != value) {
+        pin.toggles++;
+    }
+    pin.level = value;
+}
+
+// Latch the edge of an input whose level the host changed
+void LatchEdge(Pin& pin, bool before)
+{
+    bool after = PinLevel(pin);
+    if (after != before) {
+        pin.irqEvents |= pin.irqEnabled & (after ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL);
+    }
+}
+
+// Run the handlers of the pins with pending events,
+// out of the board lock, the handlers read the pins
+void RaiseGpioIrq()
+{
+    std::lock_guard<std::mutex> irq(TheBoard().irqLock);
+    std::vector<irq_handler_t> handlers;
+    {
+        std::lock_guard<std::mutex> lock(TheBoard().lock);
+        if (!TheBoard().bankIrqEnabled) {
+            return;
+        }
+        uint32_t pending = 0;
+        for (int i = 0; i < 32; i++) {
+            if (TheBoard().pins[i].irqEvents != 0) {
+                pending |= 1u << i;
+            }
+        }
+        for (const GpioIrqHandler& h : TheBoard().irqHandlers) {
+            if (h.mask & pending) {
+                handlers.push_back(h.handler);
+            }
+        }
+    }
+
+    for (irq_handler_t handler : handlers) {
+        handler();
+    }
+}
+
+uint16_t TemperatureToRaw(float celsius)
+{
+    // Inverse of the conversion in SystemThermo
+    float voltage = 0.706f - (celsius - 27.0f) * 0.001721f;
+    return static_cast<uint16_t>(voltage * 4095.0f / 3.3f + 0.5f);
+}
+
+} // namespace
+
+void HostBoard::SetInput(uint pin, bool level)
+{
+    {
+        std::lock_guard<std::mutex> lock(TheBoard().lock);
+        Pin& p = TheBoard().pins[pin];
+        bool before = PinLevel(p);
+        p.driven = level ? 1 : 0;
+        LatchEdge(p, before);
+    }
+    RaiseGpioIrq();
+}
+
+void HostBoard::ReleaseInput(uint pin)
+{
+    {
+        std::lock_guard<std::mutex> lock(TheBoard().lock);
+        Pin& p = TheBoard().pins[pin];
+        bool before = PinLevel(p);
+        p.driven = -1;
+        LatchEdge(p, before);
+    }
+    RaiseGpioIrq();
+}
+
+bool HostBoard::GetPin(uint pin)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    return PinLevel(TheBoard().pins[pin]);
+}
+
+uint32_t HostBoard::GetPinToggles(uint pin)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    return TheBoard().pins[pin].toggles;
+}
+
+void HostBoard::SetAdcRaw(uint input, uint16_t raw)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    TheBoard().adc[input] = raw;
+}
+
+void HostBoard::SetTemperature(float celsius)
+{
+    SetAdcRaw(4, TemperatureToRaw(celsius));
+}
+
+HostPwmSlice HostBoard::GetPwm(uint slice)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    return TheBoard().pwm[slice];
+}
+
+float HostBoard::GetPwmFrequency(uint slice)
+{
+    HostPwmSlice pwm = GetPwm(slice);
+    if (!pwm.enabled || (pwm.level[0] == 0 && pwm.level[1] == 0)) {
+        return 0.0f; // Stopped, or a pause of a melody
+    }
+    return clock_get_hz(clk_sys) / pwm.clkdiv / (pwm.wrap + 1.0f);
+}
+
+void HostBoard::GetLcdRow(int row, char* out)
+{
+    static const uint8_t rowOffsets[LcdRows] = {0x00, 0x40, 0x14, 0x54};
+
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    memcpy(out, &TheBoard().lcd.ddram[rowOffsets[row]], LcdCols);
+    out[LcdCols] = '\0';
+}
+
+uint32_t HostBoard::GetLcdVersion()
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    return TheBoard().lcd.version;
+}
+
+uint32_t HostBoard::GetI2CBytes()
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    return TheBoard().i2cBytes;
+}
+
+extern "C" {
+
+void gpio_init(uint gpio)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    Pin& pin = TheBoard().pins[gpio];
+    pin.output = false;
+    pin.level = false;
+}
+
+void gpio_set_dir(uint gpio, bool out)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    TheBoard().pins[gpio].output = out;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_pull_up(uint gpio)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    TheBoard().pins[gpio].pull = 1;
+}
+
+void gpio_pull_down(uint gpio)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    TheBoard().pins[gpio].pull = -1;
+}
+
+void gpio_put(uint gpio, bool value)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    PutPin(TheBoard().pins[gpio], value);
+}
+
+void gpio_put_masked(uint32_t mask, uint32_t value)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    for (int i = 0; i < 32; i++) {
+        if (mask & (1u << i)) {
+            PutPin(TheBoard().pins[i], (value >> i) & 1u);
+        }
+    }
+}
+
+bool gpio_get(uint gpio)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    return PinLevel(TheBoard().pins[gpio]);
+}
+
+uint32_t gpio_get_all(void)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    uint32_t all = 0;
+    for (int i = 0; i < 32; i++) {
+        if (PinLevel(TheBoard().pins[i])) {
+            all |= 1u << i;
+        }
+    }
+    return all;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    Pin& pin = TheBoard().pins[gpio];
+    if (enabled) {
+        pin.irqEnabled |= event_mask;
+    } else {
+        pin.irqEnabled &= ~event_mask;
+    }
+    pin.irqEvents &= pin.irqEnabled;
+}
+
+void gpio_add_raw_irq_handler_masked(uint32_t gpio_mask, irq_handler_t handler)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    TheBoard().irqHandlers.push_back({gpio_mask, handler});
+}
+
+uint32_t gpio_get_irq_event_mask(uint gpio)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    return TheBoard().pins[gpio].irqEvents;
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    TheBoard().pins[gpio].irqEvents &= ~event_mask;
+}
+
+void irq_set_enabled(uint num, bool enabled)
+{
+    if (num != IO_IRQ_BANK0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(TheBoard().lock);
+        TheBoard().bankIrqEnabled = enabled;
+    }
+    if (enabled) {
+        RaiseGpioIrq(); // The events latched while it was off
+    }
+}
+
+void adc_init(void)
+{
+    // A room temperature until the host sets another one
+    HostBoard::SetTemperature(25.0f);
+}
+
+void adc_set_temp_sensor_enabled(bool enable)
+{
+    (void)enable;
+}
+
+void adc_select_input(uint input)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    TheBoard().adcInput = input;
+}
+
+uint16_t adc_read(void)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    return TheBoard().adc[TheBoard().adcInput];
+}
+
+void pwm_init(uint slice_num, pwm_config* c, bool start)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    HostPwmSlice& pwm = TheBoard().pwm[slice_num];
+    pwm.clkdiv = c->clkdiv;
+    pwm.wrap = c->wrap;
+    pwm.enabled = start;
+    if (start) {
+        pwm.starts++;
+    }
+}
+
+void pwm_set_clkdiv(uint slice_num, float divider)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    TheBoard().pwm[slice_num].clkdiv = divider;
+}
+
+void pwm_set_clkdiv_int_frac(uint slice_num, uint8_t integer, uint8_t fract)
+{
+    pwm_set_clkdiv(slice_num, (float)integer + (float)fract / 16.0f);
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    TheBoard().pwm[slice_num].wrap = wrap;
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    TheBoard().pwm[slice_num].level[chan & 1] = level;
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled)
+{
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    HostPwmSlice& pwm = TheBoard().pwm[slice_num];
+    if (enabled && !pwm.enabled) {
+        pwm.starts++;
+    }
+    pwm.enabled = enabled;
+}
+
+uint i2c_init(i2c_inst_t* i2c, uint baudrate)
+{
+    (void)i2c;
+    return baudrate;
+}
+
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop)
+{
+    (void)i2c;
+    (void)addr;
+    (void)nostop;
+
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    for (size_t i = 0; i < len; i++) {
+        TheBoard().lcd.Write(src[i]);
+    }
+    TheBoard().i2cBytes += len;
+    return static_cast<int>(len);
+}
+
+int i2c_read_blocking(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop)
+{
+    (void)i2c;
+    (void)addr;
+    (void)nostop;
+
+    // The controller is never busy: the busy flag (bit 7) reads as clear
+    std::lock_guard<std::mutex> lock(TheBoard().lock);
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = TheBoard().lcd.port & 0x0F;
+    }
+    return static_cast<int>(len);
+}
+
+} // extern "C"
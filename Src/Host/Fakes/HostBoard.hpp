@@ -0,0 +1,62 @@
+/*
+  * HostBoard - the fake peripherals of the host build
+    * Backs the GPIO, ADC, PWM and I2C shims with plain memory, so the
+    * real drivers run unchanged and their effect can be inspected:
+    *   GPIO - output levels, inputs driven from the host, pulls,
+    *   ADC  - conversion results set from the host (the temperature sensor),
+    *   PWM  - the slice configuration, from which the tone is derived,
+    *   I2C  - a PCF8574 expander with an HD44780 controller behind it,
+    *          decoded from the nibble stream the real LCD driver sends.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "pico/types.h"
+
+struct HostPwmSlice {
+    bool enabled = false;
+    float clkdiv = 1.0f;
+    uint16_t wrap = 0xFFFF;
+    uint16_t level[2] = {0, 0};
+    uint32_t starts = 0; // Amount of pwm_init/enable calls, one per melody
+};
+
+class HostBoard {
+public:
+    static constexpr int Pins = 48;
+    static constexpr int PwmSlices = 12;
+    static constexpr int LcdRows = 4;
+    static constexpr int LcdCols = 20;
+
+    // Drive an input pin from outside, or let its pull decide again
+    static void SetInput(uint pin, bool level);
+    static void ReleaseInput(uint pin);
+
+    // The level seen on the pin
+    static bool GetPin(uint pin);
+
+    // Amount of level changes on an output pin
+    static uint32_t GetPinToggles(uint pin);
+
+    static void SetAdcRaw(uint input, uint16_t raw);
+
+    // Set the internal temperature sensor (ADC input 4)
+    static void SetTemperature(float celsius);
+
+    static HostPwmSlice GetPwm(uint slice);
+
+    // Frequency of the slice output, 0 if it is stopped
+    static float GetPwmFrequency(uint slice);
+
+    // Characters of an LCD row, the custom characters are the codes 0-7;
+    // out must hold LcdCols + 1 characters
+    static void GetLcdRow(int row, char* out);
+
+    // Grows on every change of the LCD content
+    static uint32_t GetLcdVersion();
+
+    // Amount of bytes written to the I2C bus
+    static uint32_t GetI2CBytes();
+};
@@ -0,0 +1,165 @@
+/*
+  * HostConsole - the front panel of the host build
+    * Once the scheduler runs, two threads stand in for the user:
+    *   the display thread prints the emulated LCD whenever its content
+    *   changes, with the alarm and relay outputs and the tone below it;
+    *   the input thread turns the keys read from stdin into the
+    *   encoder pin levels, with the timing of a real detent:
+    *     r - turn right, l - turn left, p - press, q - quit,
+    *     R, L - a fast spin of ten detents to the right or left.
+    * The custom characters are shown as ASCII stand-ins.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <thread>
+
+#include "FreeRTOS.h"
+#include "HostBoard.hpp"
+#include "hardware/gpio.h"
+
+namespace {
+
+// The wiring of main()
+constexpr uint EncoderPinL = 14;
+constexpr uint EncoderPinR = 15;
+constexpr uint EncoderPinBtn = 13;
+constexpr uint AlarmPin = 6;
+constexpr uint RelayPin = 9;
+constexpr uint SoundSlice = 4; // GPIO 8
+const uint BankPins[] = {16, 17, 18, 19, 20, 21, 22, 26};
+constexpr int BankChannels = sizeof(BankPins) / sizeof(BankPins[0]);
+
+// One quarter of a detent, turning slowly and spinning
+constexpr auto PhaseTime = std::chrono::milliseconds(6);
+constexpr auto FastPhaseTime = std::chrono::microseconds(200);
+constexpr int SpinDetents = 10;
+constexpr auto PressTime = std::chrono::milliseconds(30);
+constexpr auto HoldTime = std::chrono::milliseconds(1500); // A long press and a few repeats
+
+// Bell on/off, degree, clock, thermometer, arrow, relay off/on
+const char CustomChars[8] = {'B', 'b', 'o', '@', 'T', 'A', '/', '|'};
+
+// One detent is a full quadrature cycle from the rest state, both pins
+// high; the pin going low first gives the direction
+void Detent(uint first, uint second, std::chrono::microseconds phase)
+{
+    HostBoard::SetInput(first, false);
+    std::this_thread::sleep_for(phase);
+    HostBoard::SetInput(second, false);
+    std::this_thread::sleep_for(phase);
+    HostBoard::ReleaseInput(first);
+    std::this_thread::sleep_for(phase);
+    HostBoard::ReleaseInput(second);
+    std::this_thread::sleep_for(phase);
+}
+
+void Turn(bool right, int detents, std::chrono::microseconds phase)
+{
+    for (int i = 0; i < detents; i++) {
+        if (right) {
+            Detent(EncoderPinL, EncoderPinR, phase);
+        } else {
+            Detent(EncoderPinR, EncoderPinL, phase);
+        }
+    }
+}
+
+void Press(std::chrono::milliseconds holdTime = PressTime)
+{
+    HostBoard::SetInput(EncoderPinBtn, false);
+    std::this_thread::sleep_for(holdTime);
+    HostBoard::ReleaseInput(EncoderPinBtn);
+    std::this_thread::sleep_for(PressTime);
+}
+
+void PrintScreen(bool inPlace)
+{
+    char row[HostBoard::LcdCols + 1];
+
+    if (inPlace) {
+        printf("\033[H\033[2J");
+    }
+    printf("+--------------------+\n");
+    for (int r = 0; r < HostBoard::LcdRows; r++) {
+        HostBoard::GetLcdRow(r, row);
+        for (int c = 0; c < HostBoard::LcdCols; c++) {
+            unsigned char ch = static_cast<unsigned char>(row[c]);
+            if (ch < 8) {
+                row[c] = CustomChars[ch];
+            } else if (ch < ' ' || ch > '~') {
+                row[c] = '?';
+            }
+        }
+        printf("|%s|\n", row);
+    }
+    printf("+--------------------+\n");
+    char bank[BankChannels + 1];
+    for (int i = 0; i < BankChannels; i++) {
+        bank[i] = HostBoard::GetPin(BankPins[i]) ? '1' + i : '.';
+    }
+    bank[BankChannels] = '\0';
+
+    printf("alarm:%d relay:%d bank:%s tone:%4.0fHz\n",
+           HostBoard::GetPin(AlarmPin), HostBoard::GetPin(RelayPin), bank,
+           HostBoard::GetPwmFrequency(SoundSlice));
+    if (inPlace) {
+        printf("r/l - turn, R/L - spin, p - press, d - double click, h - hold, q - quit\n");
+    }
+    fflush(stdout);
+}
+
+void DisplayThread()
+{
+    bool inPlace = isatty(STDOUT_FILENO);
+    uint32_t shownVersion = 0;
+    uint32_t shownPins = 0;
+
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        // The outputs are all on GPIO 0-31
+        uint32_t version = HostBoard::GetLcdVersion();
+        uint32_t pins = gpio_get_all();
+        if (version == shownVersion && pins == shownPins) {
+            continue;
+        }
+
+        shownVersion = version;
+        shownPins = pins;
+        PrintScreen(inPlace);
+    }
+}
+
+void InputThread()
+{
+    int ch;
+    while ((ch = getchar()) != EOF) {
+        switch (ch) {
+        case 'r': Turn(true, 1, PhaseTime); break;
+        case 'l': Turn(false, 1, PhaseTime); break;
+        case 'R': Turn(true, SpinDetents, FastPhaseTime); break;
+        case 'L': Turn(false, SpinDetents, FastPhaseTime); break;
+        case 'p': Press(); break;
+        case 'd': Press(); Press(); break;
+        case 'h': Press(HoldTime); break;
+        case 'q':
+            // exit() would run the static destructors while the
+            // task threads still hold the kernel lock and hang
+            fflush(stdout);
+            _exit(0);
+        default: break;
+        }
+    }
+}
+
+} // namespace
+
+extern "C" void HostSchedulerStarted(void)
+{
+    std::thread(DisplayThread).detach();
+    std::thread(InputThread).detach();
+}
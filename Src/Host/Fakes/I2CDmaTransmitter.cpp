@@ -0,0 +1,30 @@
+/*
+  * I2CDmaTransmitter for the host build
+    * There is no DMA on the host, the transfers go to the fake
+    * board right away, as the target does before the scheduler starts.
+*/
+
+#include "hardware/i2c.h"
+
+#include "I2CDmaTransmitter.hpp"
+
+I2CDmaTransmitter *I2CDmaTransmitter::_instance = nullptr;
+
+I2CDmaTransmitter::I2CDmaTransmitter(uint8_t i2c_address, int i2c_port)
+    : _i2c_address(i2c_address), _i2c_port(i2c_port) {}
+
+void I2CDmaTransmitter::Init()
+{
+}
+
+void I2CDmaTransmitter::Transmit(const uint8_t *data, size_t length)
+{
+  if (length == 0) {
+    return;
+  }
+  i2c_write_blocking((_i2c_port == 0) ? i2c0 : i2c1, _i2c_address, data, length, false);
+}
+
+void I2CDmaTransmitter::WaitIdle()
+{
+}
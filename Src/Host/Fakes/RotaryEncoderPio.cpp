@@ -0,0 +1,21 @@
+/*
+  * The PIO decoder of RotaryEncoder for the host build
+    * There is no PIO on the host, the encoder falls back to the
+    * GPIO edge interrupts, which the fake board emulates.
+*/
+
+#include "RotaryEncoder.hpp"
+
+bool RotaryEncoder::InitPio()
+{
+    return false;
+}
+
+void RotaryEncoder::PioIrqHandler()
+{
+}
+
+bool RotaryEncoder::HandlePioFifos(uint32_t /*now*/)
+{
+    return false;
+}
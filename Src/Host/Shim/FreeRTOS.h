@@ -0,0 +1,71 @@
+/*
+  * FreeRTOS shim for the host build
+    * A thin subset of the FreeRTOS API on top of the C++ standard threads,
+    * enough to run the firmware logic as a normal Linux process.
+    * Every task is a thread; the priorities are not emulated.
+    * A critical section is a single recursive lock, which the fake
+    * interrupt handlers take as well, so taskENTER_CRITICAL keeps
+    * the same meaning as on the target.
+    * One tick is one millisecond, as configTICK_RATE_HZ is on the target.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+// The RP2350 port pulls in the SDK types as well
+#include "pico/types.h"
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+typedef struct HostQueue* QueueHandle_t;
+typedef struct HostQueue* QueueSetHandle_t;
+typedef struct HostQueue* QueueSetMemberHandle_t;
+typedef struct HostTask* TaskHandle_t;
+typedef struct HostTimer* TimerHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_FULL ((BaseType_t)0)
+#define errQUEUE_EMPTY ((BaseType_t)0)
+
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 32
+#define tskIDLE_PRIORITY 0
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+
+#define configASSERT(x) assert(x)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void HostEnterCritical(void);
+void HostExitCritical(void);
+
+void* pvPortMalloc(size_t size);
+void vPortFree(void* ptr);
+
+// Called by vTaskStartScheduler once the tasks are running;
+// the host front-end may provide it to drive the fake board
+void HostSchedulerStarted(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define taskENTER_CRITICAL() HostEnterCritical()
+#define taskEXIT_CRITICAL() HostExitCritical()
+#define taskENTER_CRITICAL_FROM_ISR() (HostEnterCritical(), 0)
+#define taskEXIT_CRITICAL_FROM_ISR(x) ((void)(x), HostExitCritical())
+#define portYIELD_FROM_ISR(x) ((void)(x))
+#define portYIELD() ((void)0)
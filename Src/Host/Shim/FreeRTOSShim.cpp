@@ -0,0 +1,496 @@
+/*
+  * FreeRTOS shim for the host build
+    * A thin subset of the FreeRTOS API on top of the C++ standard threads,
+    * enough to run the firmware logic as a normal Linux process.
+    * Every task is a thread; the priorities are not emulated.
+    * A critical section is a single recursive lock, which the fake
+    * interrupt handlers take as well, so taskENTER_CRITICAL keeps
+    * the same meaning as on the target.
+    * All the blocking calls wait on one condition variable, which
+    * is notified on every queue or notification change; with the
+    * handful of tasks the firmware has this is simple and cheap enough.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+#include "timers.h"
+
+struct HostQueue {
+    size_t length;
+    size_t itemSize;
+    std::deque<std::vector<uint8_t>> items;
+
+    bool isSet = false;
+    HostQueue* set = nullptr;            // The set this queue is a member of
+    std::deque<HostQueue*> readyMembers; // Set only: members with an item each
+};
+
+struct HostTimer {
+    TickType_t period;
+    bool autoReload;
+    void* id;
+    TimerCallbackFunction_t callback;
+    bool active = false;
+    std::chrono::steady_clock::time_point expiry;
+};
+
+struct HostTask {
+    TaskFunction_t code;
+    void* param;
+    const char* name;
+    uint32_t notifyCount = 0;
+    std::thread thread;
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::recursive_mutex& KernelLock()
+{
+    static std::recursive_mutex lock;
+    return lock;
+}
+
+std::condition_variable_any& KernelChanged()
+{
+    static std::condition_variable_any changed;
+    return changed;
+}
+
+const Clock::time_point& StartTime()
+{
+    static const Clock::time_point start = Clock::now();
+    return start;
+}
+
+bool schedulerRunning = false;
+thread_local HostTask* currentTask = nullptr;
+
+// Thrown by vTaskDelete(nullptr) to leave the task function
+struct TaskDeleted {};
+
+// Wait for the condition with the FreeRTOS timeout semantics
+template <typename Lock, typename Predicate>
+bool WaitFor(Lock& lock, TickType_t ticks, Predicate ready)
+{
+    if (ticks == 0) {
+        return ready(); // Polling, as the most calls from the ticks do
+    }
+    if (ticks == portMAX_DELAY) {
+        KernelChanged().wait(lock, ready);
+        return true;
+    }
+    return KernelChanged().wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+void Push(HostQueue* queue, const void* item, bool front)
+{
+    std::vector<uint8_t> copy(static_cast<const uint8_t*>(item),
+                              static_cast<const uint8_t*>(item) + queue->itemSize);
+    if (front) {
+        queue->items.push_front(std::move(copy));
+    } else {
+        queue->items.push_back(std::move(copy));
+    }
+
+    if (queue->set != nullptr) {
+        queue->set->readyMembers.push_back(queue);
+    }
+    KernelChanged().notify_all();
+}
+
+BaseType_t Send(HostQueue* queue, const void* item, TickType_t ticks, bool front)
+{
+    std::unique_lock<std::recursive_mutex> lock(KernelLock());
+    if (!WaitFor(lock, ticks, [queue] { return queue->items.size() < queue->length; })) {
+        return errQUEUE_FULL;
+    }
+    Push(queue, item, front);
+    return pdPASS;
+}
+
+BaseType_t Receive(HostQueue* queue, void* item, TickType_t ticks, bool remove)
+{
+    std::unique_lock<std::recursive_mutex> lock(KernelLock());
+    if (!WaitFor(lock, ticks, [queue] { return !queue->items.empty(); })) {
+        return errQUEUE_EMPTY;
+    }
+
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    if (remove) {
+        queue->items.pop_front();
+        KernelChanged().notify_all();
+    }
+    return pdPASS;
+}
+
+void RunTask(HostTask* task)
+{
+    currentTask = task;
+    {
+        // The tasks start together with the scheduler
+        std::unique_lock<std::recursive_mutex> lock(KernelLock());
+        KernelChanged().wait(lock, [] { return schedulerRunning; });
+    }
+
+    try {
+        task->code(task->param);
+    } catch (const TaskDeleted&) {
+    }
+}
+
+std::vector<HostTimer*>& Timers()
+{
+    static std::vector<HostTimer*> timers;
+    return timers;
+}
+
+// The timer service: runs the callbacks of the expired timers in turn
+void TimerThread()
+{
+    std::unique_lock<std::recursive_mutex> lock(KernelLock());
+    KernelChanged().wait(lock, [] { return schedulerRunning; });
+
+    while (true) {
+        HostTimer* due = nullptr;
+        for (HostTimer* timer : Timers()) {
+            if (timer->active && (due == nullptr || timer->expiry < due->expiry)) {
+                due = timer;
+            }
+        }
+
+        if (due == nullptr) {
+            KernelChanged().wait(lock);
+            continue;
+        }
+        if (due->expiry > Clock::now()) {
+            KernelChanged().wait_until(lock, due->expiry);
+            continue;
+        }
+
+        due->active = due->autoReload;
+        due->expiry += std::chrono::milliseconds(due->period);
+
+        // The callback may restart its own timer
+        lock.unlock();
+        due->callback(due);
+        lock.lock();
+    }
+}
+
+BaseType_t StartTimer(HostTimer* timer)
+{
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    timer->active = true;
+    timer->expiry = Clock::now() + std::chrono::milliseconds(timer->period);
+    KernelChanged().notify_all();
+    return pdPASS;
+}
+
+} // namespace
+
+extern "C" {
+
+void HostEnterCritical(void) { KernelLock().lock(); }
+void HostExitCritical(void) { KernelLock().unlock(); }
+
+void* pvPortMalloc(size_t size) { return malloc(size); }
+void vPortFree(void* ptr) { free(ptr); }
+
+__attribute__((weak)) void HostSchedulerStarted(void) {}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    HostQueue* queue = new HostQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait)
+{
+    return Send(queue, item, ticksToWait, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticksToWait)
+{
+    return Send(queue, item, ticksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticksToWait)
+{
+    return Send(queue, item, ticksToWait, true);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item)
+{
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    if (!queue->items.empty()) {
+        // A single slot queue, the set already knows about the item
+        memcpy(queue->items.front().data(), item, queue->itemSize);
+        KernelChanged().notify_all();
+        return pdPASS;
+    }
+    Push(queue, item, false);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticksToWait)
+{
+    return Receive(queue, item, ticksToWait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticksToWait)
+{
+    return Receive(queue, item, ticksToWait, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    return queue->items.size();
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    queue->items.clear();
+    KernelChanged().notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken != nullptr) {
+        *higherPriorityTaskWoken = pdFALSE;
+    }
+    return Send(queue, item, 0, false);
+}
+
+BaseType_t xQueueOverwriteFromISR(QueueHandle_t queue, const void* item, BaseType_t* higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken != nullptr) {
+        *higherPriorityTaskWoken = pdFALSE;
+    }
+    return xQueueOverwrite(queue, item);
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void* item, BaseType_t* higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken != nullptr) {
+        *higherPriorityTaskWoken = pdFALSE;
+    }
+    return Receive(queue, item, 0, true);
+}
+
+QueueSetHandle_t xQueueCreateSet(UBaseType_t length)
+{
+    HostQueue* set = xQueueCreate(length, 0);
+    set->isSet = true;
+    return set;
+}
+
+BaseType_t xQueueAddToSet(QueueSetMemberHandle_t member, QueueSetHandle_t set)
+{
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    if (member->set != nullptr || !member->items.empty()) {
+        return pdFAIL; // Same rule as on the target
+    }
+    member->set = set;
+    return pdPASS;
+}
+
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t set, TickType_t ticksToWait)
+{
+    std::unique_lock<std::recursive_mutex> lock(KernelLock());
+    if (!WaitFor(lock, ticksToWait, [set] { return !set->readyMembers.empty(); })) {
+        return nullptr;
+    }
+
+    HostQueue* member = set->readyMembers.front();
+    set->readyMembers.pop_front();
+    return member;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t stackDepth,
+                       void* param, UBaseType_t priority, TaskHandle_t* createdTask)
+{
+    (void)stackDepth;
+    (void)priority;
+
+    HostTask* task = new HostTask();
+    task->code = code;
+    task->param = param;
+    task->name = name;
+    task->thread = std::thread(RunTask, task);
+    task->thread.detach();
+
+    if (createdTask != nullptr) {
+        *createdTask = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Only a task can delete itself on the host
+    if (task == nullptr || task == currentTask) {
+        throw TaskDeleted();
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment)
+{
+    *previousWakeTime += increment;
+    std::this_thread::sleep_until(StartTime() + std::chrono::milliseconds(*previousWakeTime));
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - StartTime());
+    return static_cast<TickType_t>(elapsed.count());
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return currentTask;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    return schedulerRunning ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+
+void vTaskStartScheduler(void)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(KernelLock());
+        schedulerRunning = true;
+        KernelChanged().notify_all();
+    }
+
+    HostSchedulerStarted();
+
+    // Like on the target, the call never returns
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::hours(1));
+    }
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    task->notifyCount++;
+    KernelChanged().notify_all();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken)
+{
+    if (higherPriorityTaskWoken != nullptr) {
+        *higherPriorityTaskWoken = pdFALSE;
+    }
+    xTaskNotifyGive(task);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait)
+{
+    HostTask* task = currentTask;
+    std::unique_lock<std::recursive_mutex> lock(KernelLock());
+    if (!WaitFor(lock, ticksToWait, [task] { return task->notifyCount > 0; })) {
+        return 0;
+    }
+
+    uint32_t count = task->notifyCount;
+    task->notifyCount = clearCountOnExit ? 0 : count - 1;
+    return count;
+}
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoReload,
+                           void* timerId, TimerCallbackFunction_t callback)
+{
+    (void)name;
+
+    static std::once_flag serviceStarted;
+    std::call_once(serviceStarted, [] { std::thread(TimerThread).detach(); });
+
+    HostTimer* timer = new HostTimer();
+    timer->period = period;
+    timer->autoReload = autoReload != 0;
+    timer->id = timerId;
+    timer->callback = callback;
+
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    Timers().push_back(timer);
+    return timer;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    return StartTimer(timer);
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    return StartTimer(timer);
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    timer->active = false;
+    KernelChanged().notify_all();
+    return pdPASS;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t newPeriod, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    timer->period = newPeriod;
+    return StartTimer(timer); // Starts a dormant timer too, as on the target
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer)
+{
+    std::lock_guard<std::recursive_mutex> lock(KernelLock());
+    return timer->active ? pdTRUE : pdFALSE;
+}
+
+void* pvTimerGetTimerID(TimerHandle_t timer)
+{
+    return timer->id;
+}
+
+} // extern "C"
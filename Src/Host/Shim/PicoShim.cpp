@@ -0,0 +1,281 @@
+/*
+  * Pico SDK shim for the host build
+    * The platform services of the SDK: the microsecond timer, the sleeps,
+    * the system clock frequency, the always-on timer with its alarm and
+    * the alarm pool of the microsecond timer.
+    * The peripherals (GPIO, ADC, PWM, I2C) are faked in HostBoard.
+*/
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FreeRTOS.h"
+#include "pico/stdlib.h"
+#include "pico/aon_timer.h"
+#include "hardware/clocks.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point& StartTime()
+{
+    static const Clock::time_point start = Clock::now();
+    return start;
+}
+
+int64_t NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - StartTime()).count();
+}
+
+// The always-on timer: the wall time is the monotonic time plus an offset
+struct AonTimer {
+    std::mutex lock;
+    std::condition_variable changed;
+    int64_t offsetUs = 0;
+    bool armed = false;
+    int64_t alarmUs = 0; // Wall time of the alarm
+    aon_timer_alarm_handler_t handler = nullptr;
+    bool threadStarted = false;
+};
+
+AonTimer& Aon()
+{
+    static AonTimer aon;
+    return aon;
+}
+
+int64_t ToUs(const struct timespec* ts)
+{
+    return (int64_t)ts->tv_sec * 1000000 + ts->tv_nsec / 1000;
+}
+
+void AlarmThread()
+{
+    AonTimer& aon = Aon();
+    std::unique_lock<std::mutex> lock(aon.lock);
+
+    while (true) {
+        if (!aon.armed) {
+            aon.changed.wait(lock);
+            continue;
+        }
+
+        // The offset may change while waiting, so the deadline
+        // is recalculated on every wakeup
+        int64_t waitUs = aon.alarmUs - (NowUs() + aon.offsetUs);
+        if (waitUs > 0) {
+            aon.changed.wait_for(lock, std::chrono::microseconds(waitUs));
+            continue;
+        }
+
+        aon.armed = false;
+        aon_timer_alarm_handler_t handler = aon.handler;
+        lock.unlock();
+
+        // The handler runs as an interrupt would: nothing else
+        // enters a critical section while it is running
+        HostEnterCritical();
+        handler();
+        HostExitCritical();
+
+        lock.lock();
+    }
+}
+
+// The default alarm pool, its callbacks run on one thread
+struct AlarmPool {
+    struct Entry {
+        alarm_id_t id;
+        int64_t targetUs;
+        alarm_callback_t callback;
+        void* userData;
+    };
+
+    std::mutex lock;
+    std::condition_variable changed;
+    std::vector<Entry> entries;
+    alarm_id_t nextId = 1; // Never reused, a stale id cancels nothing
+    bool threadStarted = false;
+};
+
+AlarmPool& Pool()
+{
+    static AlarmPool pool;
+    return pool;
+}
+
+void AlarmPoolThread()
+{
+    AlarmPool& pool = Pool();
+    std::unique_lock<std::mutex> lock(pool.lock);
+
+    while (true) {
+        if (pool.entries.empty()) {
+            pool.changed.wait(lock);
+            continue;
+        }
+
+        size_t first = 0;
+        for (size_t i = 1; i < pool.entries.size(); i++) {
+            if (pool.entries[i].targetUs < pool.entries[first].targetUs) {
+                first = i;
+            }
+        }
+        int64_t waitUs = pool.entries[first].targetUs - NowUs();
+        if (waitUs > 0) {
+            pool.changed.wait_for(lock, std::chrono::microseconds(waitUs));
+            continue;
+        }
+        alarm_id_t id = pool.entries[first].id;
+        lock.unlock();
+
+        // The callback runs as an interrupt would, and the alarm may
+        // have been cancelled while the critical section was taken
+        HostEnterCritical();
+        lock.lock();
+        for (size_t i = 0; i < pool.entries.size(); i++) {
+            if (pool.entries[i].id != id) {
+                continue;
+            }
+            AlarmPool::Entry due = pool.entries[i];
+            lock.unlock();
+            int64_t again = due.callback(due.id, due.userData);
+            lock.lock();
+
+            for (size_t j = 0; j < pool.entries.size(); j++) {
+                if (pool.entries[j].id != id) {
+                    continue;
+                }
+                if (again == 0) {
+                    pool.entries.erase(pool.entries.begin() + j);
+                } else {
+                    pool.entries[j].targetUs = (again > 0) ? due.targetUs + again : NowUs() - again;
+                }
+                break;
+            }
+            break;
+        }
+        lock.unlock();
+        HostExitCritical();
+        lock.lock();
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+uint64_t time_us_64(void) { return static_cast<uint64_t>(NowUs()); }
+uint32_t time_us_32(void) { return static_cast<uint32_t>(NowUs()); }
+absolute_time_t get_absolute_time(void) { return time_us_64(); }
+
+void sleep_ms(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void sleep_us(uint64_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+void busy_wait_us(uint64_t us) { sleep_us(us); }
+
+uint32_t clock_get_hz(enum clock_index clk_index)
+{
+    return (clk_index == clk_sys) ? 150000000u : 12000000u; // RP2350 defaults
+}
+
+bool aon_timer_start(const struct timespec* ts)
+{
+    return aon_timer_set_time(ts);
+}
+
+bool aon_timer_set_time(const struct timespec* ts)
+{
+    AonTimer& aon = Aon();
+    std::lock_guard<std::mutex> lock(aon.lock);
+    aon.offsetUs = ToUs(ts) - NowUs();
+    aon.changed.notify_all();
+    return true;
+}
+
+bool aon_timer_get_time(struct timespec* ts)
+{
+    AonTimer& aon = Aon();
+    int64_t wallUs;
+    {
+        std::lock_guard<std::mutex> lock(aon.lock);
+        wallUs = NowUs() + aon.offsetUs;
+    }
+    ts->tv_sec = static_cast<time_t>(wallUs / 1000000);
+    ts->tv_nsec = static_cast<long>(wallUs % 1000000) * 1000;
+    return true;
+}
+
+aon_timer_alarm_handler_t aon_timer_enable_alarm(const struct timespec* ts,
+                                                 aon_timer_alarm_handler_t handler,
+                                                 bool wakeup_from_low_power)
+{
+    (void)wakeup_from_low_power;
+
+    AonTimer& aon = Aon();
+    std::lock_guard<std::mutex> lock(aon.lock);
+    aon_timer_alarm_handler_t previous = aon.handler;
+    aon.alarmUs = ToUs(ts);
+    aon.handler = handler;
+    aon.armed = true;
+
+    if (!aon.threadStarted) {
+        aon.threadStarted = true;
+        std::thread(AlarmThread).detach();
+    }
+    aon.changed.notify_all();
+    return previous;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* user_data, bool fire_if_past)
+{
+    (void)fire_if_past; // A late alarm always fires
+
+    AlarmPool& pool = Pool();
+    std::lock_guard<std::mutex> lock(pool.lock);
+    alarm_id_t id = pool.nextId++;
+    pool.entries.push_back({id, NowUs() + static_cast<int64_t>(us), callback, user_data});
+
+    if (!pool.threadStarted) {
+        pool.threadStarted = true;
+        std::thread(AlarmPoolThread).detach();
+    }
+    pool.changed.notify_all();
+    return id;
+}
+
+bool cancel_alarm(alarm_id_t alarm_id)
+{
+    // Waits for a callback which is running, as the interrupt
+    // would have finished before the caller could run
+    AlarmPool& pool = Pool();
+    HostEnterCritical();
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock(pool.lock);
+        for (size_t i = 0; i < pool.entries.size(); i++) {
+            if (pool.entries[i].id == alarm_id) {
+                pool.entries.erase(pool.entries.begin() + i);
+                found = true;
+                break;
+            }
+        }
+        pool.changed.notify_all();
+    }
+    HostExitCritical();
+    return found;
+}
+
+void aon_timer_disable_alarm(void)
+{
+    AonTimer& aon = Aon();
+    std::lock_guard<std::mutex> lock(aon.lock);
+    aon.armed = false;
+    aon.changed.notify_all();
+}
+
+} // extern "C"
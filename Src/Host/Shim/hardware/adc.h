@@ -0,0 +1,21 @@
+/*
+  * Pico SDK shim for the host build: ADC
+    * The conversion result comes from the fake board.
+*/
+
+#pragma once
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void adc_init(void);
+void adc_set_temp_sensor_enabled(bool enable);
+void adc_select_input(uint input);
+uint16_t adc_read(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,24 @@
+/*
+  * Pico SDK shim for the host build: clocks
+*/
+
+#pragma once
+
+#include "pico/types.h"
+
+enum clock_index {
+    clk_gpout0 = 0,
+    clk_ref = 4,
+    clk_sys = 5,
+    clk_peri = 6,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+/*
+  * Pico SDK shim for the host build: GPIO
+    * The pin levels live in the fake board (HostBoard.hpp),
+    * an input reads what the board drives or its pull.
+    * The edge interrupts of the inputs are raised by the board too.
+*/
+
+#pragma once
+
+#include "pico/types.h"
+#include "hardware/irq.h"
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+#define NUM_BANK0_GPIOS 48
+
+#define GPIO_IRQ_LEVEL_LOW 0x1u
+#define GPIO_IRQ_LEVEL_HIGH 0x2u
+#define GPIO_IRQ_EDGE_FALL 0x4u
+#define GPIO_IRQ_EDGE_RISE 0x8u
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_PIO1 = 7,
+    GPIO_FUNC_PIO2 = 8,
+    GPIO_FUNC_NULL = 0x1f,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_pull_up(uint gpio);
+void gpio_pull_down(uint gpio);
+void gpio_put(uint gpio, bool value);
+void gpio_put_masked(uint32_t mask, uint32_t value);
+bool gpio_get(uint gpio);
+uint32_t gpio_get_all(void);
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled);
+void gpio_add_raw_irq_handler_masked(uint32_t gpio_mask, irq_handler_t handler);
+uint32_t gpio_get_irq_event_mask(uint gpio);
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask);
+
+#ifdef __cplusplus
+}
+#endif
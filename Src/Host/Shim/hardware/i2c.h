@@ -0,0 +1,26 @@
+/*
+  * Pico SDK shim for the host build: I2C
+    * The bytes written to the bus go to the fake board,
+    * which emulates the PCF8574 expander with the HD44780 behind it.
+*/
+
+#pragma once
+
+#include "pico/types.h"
+
+typedef struct i2c_inst i2c_inst_t;
+
+extern i2c_inst_t* const i2c0;
+extern i2c_inst_t* const i2c1;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint i2c_init(i2c_inst_t* i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,23 @@
+/*
+  * Pico SDK shim for the host build: interrupts
+    * Only the GPIO bank interrupt is emulated, by the fake board:
+    * its handlers run on the host thread which changes an input pin.
+*/
+
+#pragma once
+
+#include "pico/types.h"
+
+#define IO_IRQ_BANK0 21
+
+typedef void (*irq_handler_t)(void);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void irq_set_enabled(uint num, bool enabled);
+
+#ifdef __cplusplus
+}
+#endif
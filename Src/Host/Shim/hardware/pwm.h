@@ -0,0 +1,42 @@
+/*
+  * Pico SDK shim for the host build: PWM
+    * The slices keep their configuration in the fake board,
+    * so the tones played can be checked from the host.
+*/
+
+#pragma once
+
+#include "pico/types.h"
+
+typedef struct {
+    float clkdiv;
+    uint16_t wrap;
+} pwm_config;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1u) & 7u; }
+static inline uint pwm_gpio_to_channel(uint gpio) { return gpio & 1u; }
+
+static inline pwm_config pwm_get_default_config(void) {
+    pwm_config c = {1.0f, 0xffff};
+    return c;
+}
+static inline void pwm_config_set_clkdiv(pwm_config* c, float div) { c->clkdiv = div; }
+static inline void pwm_config_set_clkdiv_int_frac(pwm_config* c, uint8_t integer, uint8_t fract) {
+    c->clkdiv = (float)integer + (float)fract / 16.0f;
+}
+static inline void pwm_config_set_wrap(pwm_config* c, uint16_t wrap) { c->wrap = wrap; }
+
+void pwm_init(uint slice_num, pwm_config* c, bool start);
+void pwm_set_clkdiv(uint slice_num, float divider);
+void pwm_set_clkdiv_int_frac(uint slice_num, uint8_t integer, uint8_t fract);
+void pwm_set_wrap(uint slice_num, uint16_t wrap);
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level);
+void pwm_set_enabled(uint slice_num, bool enabled);
+
+#ifdef __cplusplus
+}
+#endif
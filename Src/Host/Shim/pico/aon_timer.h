@@ -0,0 +1,30 @@
+/*
+  * Pico SDK shim for the host build: always-on timer
+    * The wall time is the host monotonic clock plus the offset
+    * set by aon_timer_start/aon_timer_set_time. The alarm handler
+    * runs on a separate thread inside the critical section lock,
+    * the way an interrupt would preempt the tasks on the target.
+*/
+
+#pragma once
+
+#include <time.h>
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*aon_timer_alarm_handler_t)(void);
+
+bool aon_timer_start(const struct timespec* ts);
+bool aon_timer_set_time(const struct timespec* ts);
+bool aon_timer_get_time(struct timespec* ts);
+aon_timer_alarm_handler_t aon_timer_enable_alarm(const struct timespec* ts,
+                                                 aon_timer_alarm_handler_t handler,
+                                                 bool wakeup_from_low_power);
+void aon_timer_disable_alarm(void);
+
+#ifdef __cplusplus
+}
+#endif
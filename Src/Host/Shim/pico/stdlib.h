@@ -0,0 +1,11 @@
+/*
+  * Pico SDK shim for the host build
+*/
+
+#pragma once
+
+#include "pico/types.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+#define PICO_DEFAULT_LED_PIN 25
@@ -0,0 +1,49 @@
+/*
+  * Pico SDK shim for the host build: time
+    * The microsecond timer counts from the start of the process.
+    * The alarms of the default alarm pool run on one thread.
+*/
+
+#pragma once
+
+#include "pico/types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+absolute_time_t get_absolute_time(void);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void busy_wait_us(uint64_t us);
+
+typedef int32_t alarm_id_t;
+
+// Returns 0 to stop, > 0 to run again that long after the time the alarm
+// was due, < 0 to run again that long after the callback was called
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void* user_data);
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+
+static inline alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void* user_data, bool fire_if_past) {
+    return add_alarm_in_us((uint64_t)ms * 1000, callback, user_data, fire_if_past);
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return get_absolute_time() + (uint64_t)ms * 1000;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,13 @@
+/*
+  * Pico SDK shim for the host build: basic types
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
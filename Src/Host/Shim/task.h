@@ -0,0 +1,34 @@
+/*
+  * FreeRTOS task shim for the host build
+*/
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+#define taskSCHEDULER_SUSPENDED ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING ((BaseType_t)2)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char* name, uint32_t stackDepth,
+                       void* param, UBaseType_t priority, TaskHandle_t* createdTask);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t increment);
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskGetSchedulerState(void);
+void vTaskStartScheduler(void);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken);
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+/*
+  * FreeRTOS software timer shim for the host build
+    * The callbacks run on one timer thread, as they run
+    * in the timer service task on the target.
+*/
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TimerHandle_t xTimerCreate(const char* name, TickType_t period, UBaseType_t autoReload,
+                           void* timerId, TimerCallbackFunction_t callback);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticksToWait);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticksToWait);
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticksToWait);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t newPeriod, TickType_t ticksToWait);
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+void* pvTimerGetTimerID(TimerHandle_t timer);
+
+#ifdef __cplusplus
+}
+#endif
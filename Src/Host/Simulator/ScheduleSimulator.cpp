@@ -0,0 +1,490 @@
+/*
+  * Schedule Simulator
+    * Runs the alarm and relay schedules over a long period as fast as
+    * the host allows: synthetic ClockEvents are handed to Alarm and Relay
+    * the same way ScheduleTask does, the calendar advances through
+    * DateTime only (no DST, no time zone), and every On/Off edge goes to
+    * a compact log, one line each: "2024-02-29 07:00:00 A+ 0" is the
+    * alarm going on because of its window 0, "R-" the relay going off.
+    * Every step is also checked against a plain reference model of
+    * the windows, so a matching bug shows up as a mismatch with the
+    * moment it happened, and the run ends with the throughput.
+    *   schedule-sim [--from 2024-01-01] [--days 366] [--step 1] [--wakeup]
+    *                [--alarm "Mo-Fr 07:00 30"]... [--relay "Mo-Fr 07:50-08:10"]...
+    *                [--jump "2024-03-04 12:00 -3600"]... [--log FILE]
+    * With --wakeup the events come only at the transitions the actuators
+    * ask for, as with the ticks turned off on the target.
+    * A --jump sets the time forward or back by the given seconds when the
+    * run reaches the moment, the TimeJump goes through CatchUp as in
+    * ScheduleTask and its Missed count is checked against the windows
+    * the reference model sees skipped.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "Alarm.hpp"
+#include "Clock.hpp"
+#include "Relay.hpp"
+#include "RelaySchedule.hpp"
+
+namespace {
+
+// The time is set from `at` to `at + seconds`
+struct Jump {
+    DateTime at;
+    int64_t seconds;
+};
+
+struct Options {
+    DateTime from{2024, 1, 1, 0, 0, 0}; // A leap year
+    int days = 366;
+    int step = 1;
+    bool wakeup = false;
+    const char* logPath = nullptr;
+
+    AlarmConfig alarms[Alarm::MaxConfigs];
+    int alarmCount = 0;
+    RelayConfig relays[Relay::MaxConfigs];
+    int relayCount = 0;
+    Jump jumps[8];
+    int jumpCount = 0;
+};
+
+struct Stats {
+    uint64_t events = 0;
+    uint64_t alarmEdges = 0;
+    uint64_t relayEdges = 0;
+    uint64_t missed = 0;
+    uint64_t expectedMissed = 0;
+    uint64_t jumps = 0;
+    uint64_t mismatches = 0;
+};
+
+// The weekdays of "Mo-Fr 07:00 ...", AllDays if the text starts with the time
+bool ParseDays(const char*& text, uint8_t& weekdays)
+{
+    weekdays = RelayWindow::AllDays;
+    if (*text < 'A' || *text > 'Z') {
+        return true;
+    }
+
+    // Reuse the day list parser of the relay windows
+    const char* space = strchr(text, ' ');
+    if (space == nullptr) {
+        return false;
+    }
+
+    char window[48];
+    snprintf(window, sizeof(window), "%.*s 00:00-00:01", static_cast<int>(space - text), text);
+    RelayWindow parsed;
+    if (!RelaySchedule::ParseWindow(window, parsed)) {
+        return false;
+    }
+
+    weekdays = parsed.weekdays;
+    text = space + 1;
+    return true;
+}
+
+// "[days] HH:MM[:SS] seconds"
+bool ParseAlarm(const char* text, AlarmConfig& out)
+{
+    uint8_t weekdays;
+    if (!ParseDays(text, weekdays)) {
+        return false;
+    }
+
+    int hour = 0, minute = 0, second = 0, duration = 0;
+    if (sscanf(text, "%d:%d:%d %d", &hour, &minute, &second, &duration) != 4) {
+        second = 0;
+        if (sscanf(text, "%d:%d %d", &hour, &minute, &duration) != 3) {
+            return false;
+        }
+    }
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59 ||
+        second < 0 || second > 59 || duration <= 0) {
+        return false;
+    }
+
+    out.timeBeg = {2025, 1, 1, hour, minute, second};
+    out.duration = duration;
+    out.enabled = true;
+    out.weekdays = weekdays;
+    out.CalcAlarmTimeEnd();
+    return true;
+}
+
+bool ParseRelay(const char* text, RelayConfig& out)
+{
+    RelayWindow window;
+    if (!RelaySchedule::ParseWindow(text, window)) {
+        return false;
+    }
+
+    out.timeBeg = {2025, 1, 1, 0, 0, 0};
+    out.timeEnd = {2025, 1, 1, 0, 0, 0};
+    out.FromWindow(window);
+    out.enabled = true;
+    return true;
+}
+
+bool ParseDate(const char* text, DateTime& out)
+{
+    int year, month, day;
+    if (sscanf(text, "%d-%d-%d", &year, &month, &day) != 3 ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+
+    out = DateTime(year, month, day, 0, 0, 0);
+    return true;
+}
+
+// "YYYY-MM-DD HH:MM[:SS] SECONDS", the seconds may be negative
+bool ParseJump(const char* text, Jump& out)
+{
+    int year, month, day, hour, minute, second = 0;
+    long long seconds;
+    if (sscanf(text, "%d-%d-%d %d:%d:%d %lld", &year, &month, &day, &hour, &minute, &second, &seconds) != 7) {
+        second = 0;
+        if (sscanf(text, "%d-%d-%d %d:%d %lld", &year, &month, &day, &hour, &minute, &seconds) != 6) {
+            return false;
+        }
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour < 0 || hour > 23 ||
+        minute < 0 || minute > 59 || second < 0 || second > 59 || seconds == 0) {
+        return false;
+    }
+
+    out.at = DateTime(year, month, day, hour, minute, second);
+    out.seconds = seconds;
+    return true;
+}
+
+void Usage()
+{
+    fprintf(stderr,
+            "usage: schedule-sim [--from YYYY-MM-DD] [--days N] [--step SECONDS] [--wakeup]\n"
+            "                    [--alarm \"[days] HH:MM[:SS] SECONDS\"]... [--relay \"[days] HH:MM-HH:MM\"]...\n"
+            "                    [--jump \"YYYY-MM-DD HH:MM[:SS] SECONDS\"]... [--log FILE]\n");
+    exit(2);
+}
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++) {
+        const char* name = argv[i];
+        if (strcmp(name, "--wakeup") == 0) {
+            options.wakeup = true;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if (strcmp(name, "--from") == 0) {
+            if (!ParseDate(value, options.from)) {
+                return false;
+            }
+        } else if (strcmp(name, "--days") == 0) {
+            options.days = atoi(value);
+        } else if (strcmp(name, "--step") == 0) {
+            options.step = atoi(value);
+        } else if (strcmp(name, "--log") == 0) {
+            options.logPath = value;
+        } else if (strcmp(name, "--alarm") == 0) {
+            if (options.alarmCount == Alarm::MaxConfigs ||
+                !ParseAlarm(value, options.alarms[options.alarmCount++])) {
+                return false;
+            }
+        } else if (strcmp(name, "--relay") == 0) {
+            if (options.relayCount == Relay::MaxConfigs ||
+                !ParseRelay(value, options.relays[options.relayCount++])) {
+                return false;
+            }
+        } else if (strcmp(name, "--jump") == 0) {
+            // Taken in the given order, each one once
+            if (options.jumpCount == static_cast<int>(sizeof(options.jumps) / sizeof(options.jumps[0])) ||
+                !ParseJump(value, options.jumps[options.jumpCount++])) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    if (options.alarmCount == 0 && options.relayCount == 0) {
+        // A workday alarm, a window around it and one over the midnight
+        ParseAlarm("Mo-Fr 07:00 30", options.alarms[options.alarmCount++]);
+        ParseRelay("Mo-Fr 07:50-08:10", options.relays[options.relayCount++]);
+        ParseRelay("Sa,Su 22:00-06:00", options.relays[options.relayCount++]);
+    }
+
+    return options.days > 0 && options.step > 0;
+}
+
+// The reference model: the window which started on some day covers
+// the moment; written for clarity, not speed
+
+bool AlarmExpected(const Options& options, const DateTime& time)
+{
+    for (int i = 0; i < options.alarmCount; i++) {
+        const AlarmConfig& config = options.alarms[i];
+        int64_t spanDays = config.duration / DateTime::SecondsPerDay + 1;
+
+        for (int64_t back = 0; back <= spanDays; back++) {
+            DateTime day = DateTime::FromSeconds((time.Days() - back) * DateTime::SecondsPerDay);
+            if (!config.IsActiveOn(day.DayOfWeek())) {
+                continue;
+            }
+
+            DateTime start = day + config.timeBeg.SecondOfDay();
+            if (time >= start && time < start + config.duration) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool RelayExpected(const Options& options, const DateTime& time)
+{
+    for (int i = 0; i < options.relayCount; i++) {
+        const RelayConfig& config = options.relays[i];
+        int64_t beg = config.timeBeg.SecondOfDay() / DateTime::SecondsPerMinute * DateTime::SecondsPerMinute;
+        int64_t end = config.timeEnd.SecondOfDay() / DateTime::SecondsPerMinute * DateTime::SecondsPerMinute;
+        if (end == beg) {
+            continue;
+        }
+        if (end < beg) {
+            end += DateTime::SecondsPerDay; // Over the midnight
+        }
+
+        for (int64_t back = 0; back <= 1; back++) {
+            DateTime day = DateTime::FromSeconds((time.Days() - back) * DateTime::SecondsPerDay);
+            if ((config.weekdays & (1 << day.DayOfWeek())) == 0) {
+                continue;
+            }
+            if (time >= day + beg && time < day + end) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// The windows which opened and closed again between the two times,
+// the ones CatchUp has to report as missed after a jump forward
+uint64_t MissedExpected(const Options& options, const DateTime& from, const DateTime& to)
+{
+    uint64_t missed = 0;
+
+    for (int i = 0; i < options.alarmCount; i++) {
+        const AlarmConfig& config = options.alarms[i];
+        int64_t spanDays = config.duration / DateTime::SecondsPerDay + 1;
+
+        for (int64_t days = from.Days() - spanDays; days <= to.Days(); days++) {
+            DateTime day = DateTime::FromSeconds(days * DateTime::SecondsPerDay);
+            if (!config.IsActiveOn(day.DayOfWeek())) {
+                continue;
+            }
+
+            DateTime start = day + config.timeBeg.SecondOfDay();
+            if (start > from && start + config.duration <= to) {
+                missed++;
+            }
+        }
+    }
+
+    // The relay windows switch on the minutes; every rise of the
+    // combined output is a window, unless it is still open at the end
+    uint64_t rises = 0;
+    int64_t minute = (from.seconds / DateTime::SecondsPerMinute + 1) * DateTime::SecondsPerMinute;
+    for (; minute <= to.seconds; minute += DateTime::SecondsPerMinute) {
+        DateTime time = DateTime::FromSeconds(minute);
+        if (RelayExpected(options, time) && !RelayExpected(options, time - 1)) {
+            rises++;
+        }
+    }
+    if (rises > 0 && RelayExpected(options, to)) {
+        rises--;
+    }
+
+    return missed + rises;
+}
+
+void LogEdge(FILE* log, const DateTime& time, char actuator, bool on, int index)
+{
+    if (log == nullptr) {
+        return;
+    }
+
+    CivilTime civil = time.ToCivil();
+    fprintf(log, "%04d-%02d-%02d %02d:%02d:%02d %c%c %d\n",
+            civil.year, civil.month, civil.day, civil.hour, civil.minute, civil.second,
+            actuator, on ? '+' : '-', index);
+}
+
+// Take the events of one actuator off its queue and log the edges
+template <typename Actuator>
+void DrainEvents(const Actuator& actuator, char name, const DateTime& time, FILE* log,
+                 uint64_t& edges, Stats& stats)
+{
+    typename Actuator::Event evt;
+    while (xQueueReceive(actuator.GetEventQueue(), &evt, 0)) {
+        switch (evt.type) {
+            case ActuatorEventType::On:
+            case ActuatorEventType::Off:
+                edges++;
+                LogEdge(log, time, name, evt.type == ActuatorEventType::On, evt.index);
+                break;
+            case ActuatorEventType::Missed:
+                stats.missed += evt.missed;
+                break;
+            case ActuatorEventType::Reconfigured:
+                break;
+        }
+    }
+}
+
+void ReportMismatch(Stats& stats, const DateTime& time, char name, bool actual)
+{
+    if (stats.mismatches++ < 10) {
+        CivilTime civil = time.ToCivil();
+        fprintf(stderr, "mismatch at %04d-%02d-%02d %02d:%02d:%02d: %c is %s, expected %s\n",
+                civil.year, civil.month, civil.day, civil.hour, civil.minute, civil.second,
+                name, actual ? "on" : "off", actual ? "off" : "on");
+    }
+}
+
+void ReportMissedMismatch(Stats& stats, const ClockEvent& jump, uint64_t actual, uint64_t expected)
+{
+    if (stats.mismatches++ < 10) {
+        CivilTime from = jump.previousTime.ToCivil();
+        CivilTime to = jump.currentTime.ToCivil();
+        fprintf(stderr, "mismatch at the jump %04d-%02d-%02d %02d:%02d:%02d -> %04d-%02d-%02d %02d:%02d:%02d: "
+                "%llu missed, expected %llu\n",
+                from.year, from.month, from.day, from.hour, from.minute, from.second,
+                to.year, to.month, to.day, to.hour, to.minute, to.second,
+                static_cast<unsigned long long>(actual), static_cast<unsigned long long>(expected));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        Usage();
+    }
+
+    FILE* log = nullptr;
+    if (options.logPath != nullptr) {
+        log = (strcmp(options.logPath, "-") == 0) ? stdout : fopen(options.logPath, "w");
+        if (log == nullptr) {
+            perror(options.logPath);
+            return 2;
+        }
+    }
+
+    Alarm alarm(8);
+    Relay relay(8);
+    alarm.SetConfigs(options.alarms, options.alarmCount);
+    relay.SetConfigs(options.relays, options.relayCount);
+
+    Stats stats;
+    DrainEvents(alarm, 'A', options.from, nullptr, stats.alarmEdges, stats);
+    DrainEvents(relay, 'R', options.from, nullptr, stats.relayEdges, stats);
+
+    DateTime end = options.from + options.days * DateTime::SecondsPerDay;
+    ClockEvent clockEvent{ClockEventType::Tick, options.from, options.from};
+    int nextJump = 0;
+
+    auto started = std::chrono::steady_clock::now();
+
+    while (clockEvent.currentTime < end) {
+        // The handling of ScheduleTask
+        uint64_t missedBefore = stats.missed;
+        uint64_t missedExpected = 0;
+        if (clockEvent.type == ClockEventType::TimeJump) {
+            alarm.CatchUp(clockEvent.previousTime, clockEvent.currentTime);
+            relay.CatchUp(clockEvent.previousTime, clockEvent.currentTime);
+            if (clockEvent.currentTime > clockEvent.previousTime) {
+                missedExpected = MissedExpected(options, clockEvent.previousTime, clockEvent.currentTime);
+            }
+            stats.jumps++;
+        } else {
+            alarm.ProcessCurrentTime(clockEvent.currentTime);
+            relay.ProcessCurrentTime(clockEvent.currentTime);
+        }
+        stats.events++;
+
+        const DateTime& now = clockEvent.currentTime;
+        DrainEvents(alarm, 'A', now, log, stats.alarmEdges, stats);
+        DrainEvents(relay, 'R', now, log, stats.relayEdges, stats);
+
+        ActuatorState alarmState, relayState;
+        alarm.GetState(alarmState);
+        relay.GetState(relayState);
+        if (alarmState.ringing != AlarmExpected(options, now)) {
+            ReportMismatch(stats, now, 'A', alarmState.ringing);
+        }
+        if (relayState.ringing != RelayExpected(options, now)) {
+            ReportMismatch(stats, now, 'R', relayState.ringing);
+        }
+        stats.expectedMissed += missedExpected;
+        if (stats.missed - missedBefore != missedExpected) {
+            ReportMissedMismatch(stats, clockEvent, stats.missed - missedBefore, missedExpected);
+        }
+
+        if (nextJump < options.jumpCount && options.jumps[nextJump].at <= now) {
+            const Jump& jump = options.jumps[nextJump++];
+            clockEvent.type = ClockEventType::TimeJump;
+            clockEvent.previousTime = now;
+            clockEvent.currentTime = now + jump.seconds;
+        } else if (options.wakeup) {
+            DateTime alarmNext = alarm.NextTransition(now);
+            DateTime relayNext = relay.NextTransition(now);
+            clockEvent.type = ClockEventType::Transition;
+            clockEvent.currentTime = alarmNext < relayNext ? alarmNext : relayNext;
+        } else {
+            clockEvent.type = ClockEventType::Tick;
+            clockEvent.currentTime = now + options.step;
+        }
+
+        // The time stops at the moment of the jump, it is taken from there
+        if (clockEvent.type != ClockEventType::TimeJump && nextJump < options.jumpCount &&
+            options.jumps[nextJump].at < clockEvent.currentTime) {
+            clockEvent.currentTime = options.jumps[nextJump].at;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    if (log != nullptr && log != stdout) {
+        fclose(log);
+    }
+
+    fprintf(stderr, "%d days from %04d-%02d-%02d, %s\n", options.days,
+            options.from.ToCivil().year, options.from.ToCivil().month, options.from.ToCivil().day,
+            options.wakeup ? "transitions only" : "ticks");
+    fprintf(stderr, "events: %llu in %.3f s, %.0f per second\n",
+            static_cast<unsigned long long>(stats.events), seconds,
+            seconds > 0 ? stats.events / seconds : 0.0);
+    fprintf(stderr, "edges: alarm %llu, relay %llu; missed windows %llu of %llu expected in %llu jumps\n",
+            static_cast<unsigned long long>(stats.alarmEdges),
+            static_cast<unsigned long long>(stats.relayEdges),
+            static_cast<unsigned long long>(stats.missed),
+            static_cast<unsigned long long>(stats.expectedMissed),
+            static_cast<unsigned long long>(stats.jumps));
+    fprintf(stderr, "mismatches: %llu\n", static_cast<unsigned long long>(stats.mismatches));
+
+    return stats.mismatches == 0 ? 0 : 1;
+}
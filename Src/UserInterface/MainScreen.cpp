@@ -71,6 +71,13 @@ void MainScreen::ProcessCommand(const MainScreenCommand& cmd)
         }
         break;
 
+        case MainScreenCommandType::SetRelayBankState:
+        relayBankState.CopyFrom(cmd.relayBankState);
+        if (cmd.render) {
+                inner_Render();
+        }
+        break;
+
         default:
         // Handle unknown command type
         break;
@@ -91,10 +98,11 @@ void MainScreen::inner_Render()
     display->PrintCustomCharacter(0, 0, 0x03);
 
     // Format the time and date strings
+    CivilTime civil = clockTime.ToCivil();
     snprintf(lineClockTime, sizeof(lineClockTime), "%04d.%02d.%02d",
-            clockTime.year, clockTime.month, clockTime.day);
+            civil.year, civil.month, civil.day);
     snprintf(lineClockDate, sizeof(lineClockDate), "%02d:%02d:%02d",
-            clockTime.hour, clockTime.minute, clockTime.second);
+            civil.hour, civil.minute, civil.second);
 
     display->PrintLine(0, 1, lineClockTime);
     display->PrintLine(0, 12, lineClockDate);
@@ -107,13 +115,25 @@ void MainScreen::inner_Render()
     // Draw the Thermometer symbol
     display->PrintCustomCharacter(1, 0, 0x04);
 
-    // Format the temperature reading
-    snprintf(lineTemperature, sizeof(lineTemperature), "Temperature: %.1f C", temperature);
+    if (relayBankState.channels == 0) {
+        // Format the temperature reading, the degree symbol (0x02) is
+        // part of the line, so the unchanged cell is not sent again
+        snprintf(lineTemperature, sizeof(lineTemperature), "Temperature: %.1f\x02" "C", temperature);
+
+        display->PrintLine(1, 1, lineTemperature);
+    } else {
+        // Short temperature and the relay bank, one character per
+        // channel: its number if it is on, a dot if it is off
+        char channels[RelayBank::MaxChannels + 1];
+        for (int i = 0; i < relayBankState.channels; i++) {
+            channels[i] = (relayBankState.mask & (1u << i)) ? '1' + i : '.';
+        }
+        channels[relayBankState.channels] = '\0';
 
-    display->PrintLine(1, 1, lineTemperature);
+        snprintf(lineTemperature, sizeof(lineTemperature), "%5.1f\x02" "C Ch:%-8s", temperature, channels);
 
-    // Print the degree symbol
-    display->PrintCustomCharacter(1, 18, 0x02); // Print degree symbol
+        display->PrintLine(1, 1, lineTemperature);
+    }
 
 
     //// //// //// //// //// //// ////
@@ -124,9 +144,11 @@ void MainScreen::inner_Render()
     display->PrintCustomCharacter(2, 0, relayState.ringing ? 0x07 : 0x06);
 
     // Format the Relay status string
+    CivilTime relayBeg = relayConfig.timeBeg.ToCivil();
+    CivilTime relayEnd = relayConfig.timeEnd.ToCivil();
     snprintf(lineForRelay, sizeof(lineForRelay), "Relay: %02d:%02d-%02d:%02d",
-            relayConfig.timeBeg.hour, relayConfig.timeBeg.minute, 
-            relayConfig.timeEnd.hour, relayConfig.timeEnd.minute);
+            relayBeg.hour, relayBeg.minute, 
+            relayEnd.hour, relayEnd.minute);
 
     display->PrintLine(2, 1, lineForRelay);
 
@@ -139,10 +161,11 @@ void MainScreen::inner_Render()
     display->PrintCustomCharacter(3, 0, alarmConfig.enabled && alarmState.ringing ? 0x00 : 0x01);
 
     // Format the alarm information
+    CivilTime alarmBeg = alarmConfig.timeBeg.ToCivil();
     snprintf(lineForAlarm, sizeof(lineForAlarm), "%02d sec at %02d:%02d %s", 
             alarmConfig.duration, 
-            alarmConfig.timeBeg.hour, 
-            alarmConfig.timeBeg.minute, 
+            alarmBeg.hour, 
+            alarmBeg.minute, 
             alarmConfig.enabled ? "On" : "Off");
 
     display->PrintLine(3, 1, lineForAlarm);
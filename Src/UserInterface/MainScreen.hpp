@@ -3,6 +3,7 @@
 #include "../Clock/Clock.hpp"
 #include "../Clock/Relay.hpp"
 #include "../Clock/Alarm.hpp"
+#include "../Clock/RelayBank.hpp"
 
 #include "../Display/IDisplay.hpp"
 
@@ -15,6 +16,7 @@ enum class MainScreenCommandType {
     SetRelayState,
     SetAlarmConfig,
     SetAlarmState,
+    SetRelayBankState,
 };
 
 struct MainScreenCommand {
@@ -28,6 +30,7 @@ struct MainScreenCommand {
         RelayState relayState;
         AlarmConfig alarmConfig;
         AlarmState alarmState;
+        RelayBankState relayBankState;
     };
 };
 
@@ -101,6 +104,14 @@ public:
         xQueueSend(commandQueue, &cmd, portMAX_DELAY);
     }
 
+    void SetRelayBankState(const RelayBankState& state, bool render = false) {
+        MainScreenCommand cmd = {};
+        cmd.type = MainScreenCommandType::SetRelayBankState;
+        cmd.relayBankState.CopyFrom(state);
+        cmd.render = render;
+        xQueueSend(commandQueue, &cmd, portMAX_DELAY);
+    }
+
     private:
     void inner_Render();
     QueueHandle_t commandQueue;
@@ -114,6 +125,7 @@ private:
     AlarmConfig alarmConfig;
     RelayState relayState;
     AlarmState alarmState;
+    RelayBankState relayBankState;
 
 private:
     IDisplay* display;
@@ -1,5 +1,6 @@
 #include "string.h"
 #include <cstdio>
+#include <cstdlib>
 
 #include "MenuController.hpp"
 #include "../Display/Display.hpp"
@@ -19,12 +20,55 @@ MenuController::MenuController(Clock* clock, Alarm* alarm, Relay* relay, MenuScr
         menuScreen->SetHeader("Menu");
     }
 
-void MenuController::ProcessEvent(MenuEvent event) {
-    ProcessMenuEvent(event);
+void MenuController::ProcessEvent(MenuEvent event, int detents, int steps) {
+    ProcessMenuEvent(event, detents, steps);
     Render();
 }
 
-void MenuController::ProcessMenuEvent(MenuEvent event) {
+void MenuController::ProcessEncoderEvent(const EncoderEvent& evt, uint32_t mergedEvents) {
+    switch (evt.type) {
+        case EncoderEventType::Rotated:
+            if (evt.delta == 0) {
+                return;
+            }
+            ProcessEvent(evt.delta > 0 ? MenuEvent::MoveFwd : MenuEvent::MoveBack,
+                         abs(evt.delta), abs(evt.steps));
+            break;
+
+        case EncoderEventType::Pressed:
+            ProcessEvent(MenuEvent::PushButton);
+            break;
+
+        case EncoderEventType::DoubleClick:
+            ProcessEvent(MenuEvent::DoubleClick);
+            break;
+
+        case EncoderEventType::LongPress:
+            ProcessEvent(MenuEvent::LongPress);
+            break;
+
+        case EncoderEventType::HoldRepeat:
+            return; // No page uses it yet, it would only render again
+
+        default:
+            return; // Ignore unknown events
+    }
+
+    uint32_t latency = time_us_32() - evt.timeUs;
+    stats.events++;
+    stats.mergedEvents += mergedEvents;
+    stats.lastLatencyUs = latency;
+    if (latency > stats.maxLatencyUs) {
+        stats.maxLatencyUs = latency;
+    }
+}
+
+void MenuController::ProcessMenuEvent(MenuEvent event, int detents, int steps) {
+    // Outside the pages a double click is taken as a click
+    if (event == MenuEvent::DoubleClick && menuState != MenuState::EditScreen) {
+        event = MenuEvent::PushButton;
+    }
+
     switch (menuState) {
         case MenuState::MainScreen:
             // In the main screen, we only handle the push button event to enter the menu
@@ -50,11 +94,17 @@ void MenuController::ProcessMenuEvent(MenuEvent event) {
         case MenuState::MenuScreen:
             if (event == MenuEvent::MoveFwd)
             {
-                SelectNextItem();
+                SelectNextItem(detents);
             }
             else if (event == MenuEvent::MoveBack)
             {
-                SelectPrevItem();
+                SelectPrevItem(detents);
+            }
+            else if (event == MenuEvent::LongPress)
+            {
+                // A long press leaves the menu from any item
+                menuState = MenuState::MainScreen;
+                display->Clear();
             }
             else if (event == MenuEvent::PushButton)
             {
@@ -95,26 +145,11 @@ void MenuController::ProcessMenuEvent(MenuEvent event) {
                         page->Render();
                     }
 
-                    else if(menuContent->currentItem->IsTypeOf(MenuItemType::AlarmTime)){
-                        IPage *page = menuContent->currentItem->GetPage();
-                        if(page == nullptr)
-                        {
-                            AlarmConfig alarmConfig;
-                            alarm->GetAlarmConfig(alarmConfig);
-                            page = new PageForTime(display, 1, 4, alarmConfig.timeBeg, menuContent->currentItem->GetHeader(), PageForTimeMode::WithoutSeconds);
-                            menuContent->currentItem->SetPage(page);
-                        }
-                        page->PrepareDisplay();
-                        page->Render();
-                    }
-
                     else if(menuContent->currentItem->IsTypeOf(MenuItemType::AlarmConfig)){
                         IPage *page = menuContent->currentItem->GetPage();
                         if(page == nullptr)
                         {
-                            AlarmConfig alarmConfig;
-                            alarm->GetAlarmConfig(alarmConfig);
-                            page = new PageForAlrm(display, 1, 2, alarmConfig.duration, alarmConfig.enabled, menuContent->currentItem->GetHeader());
+                            page = new PageForAlrm(display, 1, 0, alarm, menuContent->currentItem->GetHeader());
                             menuContent->currentItem->SetPage(page);
                         }
                         page->PrepareDisplay();
@@ -126,7 +161,7 @@ void MenuController::ProcessMenuEvent(MenuEvent event) {
                         if(page == nullptr)
                         {
                             RelayConfig relayConfig;
-                            relay->GetRelayConfig(relayConfig);
+                            relay->GetConfig(0, relayConfig);
                             page = new PageForRelay(display, 1, 2, relayConfig.timeBeg, relayConfig.timeEnd, menuContent->currentItem->GetHeader());
                             menuContent->currentItem->SetPage(page);
                         }
@@ -151,7 +186,7 @@ void MenuController::ProcessMenuEvent(MenuEvent event) {
                         if(page != nullptr)
                         {
                             EventProcessingResult result = 
-                                page->ProcessMenuEvent(event);
+                                page->ProcessMenuEvent(event, detents, steps);
                             if(result == EventProcessingResult::Continue)
                             {
                                 return; // Continue processing in the page
@@ -180,7 +215,7 @@ void MenuController::ProcessMenuEvent(MenuEvent event) {
                         if(page != nullptr)
                         {
                             EventProcessingResult result = 
-                                page->ProcessMenuEvent(event);
+                                page->ProcessMenuEvent(event, detents, steps);
                             if(result == EventProcessingResult::Continue)
                             {
                                 return; // Continue processing in the page
@@ -204,56 +239,21 @@ void MenuController::ProcessMenuEvent(MenuEvent event) {
                         }
                     }
 
-                    else if(menuContent->currentItem->IsTypeOf(MenuItemType::AlarmTime))
-                    {
-                        if(page != nullptr)
-                        {
-                            EventProcessingResult result = 
-                                page->ProcessMenuEvent(event);
-                            if(result == EventProcessingResult::Continue)
-                            {
-                                return; // Continue processing in the page
-                            }
-                            if(result == EventProcessingResult::Apply)
-                            {
-                                    AlarmConfig alarmConfig;
-                                    alarm->GetAlarmConfig(alarmConfig);
-                                    DateTime editorValue;
-                                    ((PageForTime*)(page))->GetCurrentTime(editorValue);
-                                    alarmConfig.timeBeg.CopyTimeFrom(editorValue);
-
-                                    // Apply the changes to the clock
-                                    alarm->SetAlarmConfig(alarmConfig);
-                            }
-                            delete page;
-                            page = nullptr;
-                            menuContent->currentItem->SetPage(nullptr);
-                            menuState = MenuState::MenuScreen;
-                            display->Clear();
-                        }
-                    }
-
                     else if(menuContent->currentItem->IsTypeOf(MenuItemType::AlarmConfig))
                     {
                         if(page != nullptr)
                         {
                             EventProcessingResult result = 
-                                page->ProcessMenuEvent(event);
+                                page->ProcessMenuEvent(event, detents, steps);
                             if(result == EventProcessingResult::Continue)
                             {
                                 return; // Continue processing in the page
                             }
                             if(result == EventProcessingResult::Apply)
                             {
-                                    bool enabled;
-                                    int seconds;
-                                    AlarmConfig alarmConfig;
-                                    alarm->GetAlarmConfig(alarmConfig);
-                                    ((PageForAlrm*)(page))->GetCurrentState(seconds, enabled);
-                                    alarmConfig.duration = seconds;
-                                    alarmConfig.enabled = enabled;
-                                    // Apply the changes to the clock
-                                    alarm->SetAlarmConfig(alarmConfig);
+                                    // Apply the changes to all the alarms at once
+                                    alarm->SetConfigs(((PageForAlrm*)(page))->GetAlarmConfigs(), Alarm::MaxConfigs);
+                                    clock->RequestReschedule();
                             }
                             delete page;
                             page = nullptr;
@@ -268,7 +268,7 @@ void MenuController::ProcessMenuEvent(MenuEvent event) {
                         if(page != nullptr)
                         {
                             EventProcessingResult result = 
-                                page->ProcessMenuEvent(event);
+                                page->ProcessMenuEvent(event, detents, steps);
                             if(result == EventProcessingResult::Continue)
                             {
                                 return; // Continue processing in the page
@@ -276,10 +276,11 @@ void MenuController::ProcessMenuEvent(MenuEvent event) {
                             if(result == EventProcessingResult::Apply)
                             {
                                     RelayConfig relayConfig;
-                                    relay->GetRelayConfig(relayConfig);
+                                    relay->GetConfig(0, relayConfig);
                                     ((PageForRelay*)(page))->GetRelayTimes(relayConfig.timeBeg, relayConfig.timeEnd);
                                     // Apply the changes to the clock
-                                    relay->SetRelayConfig(relayConfig);
+                                    relay->SetConfig(0, relayConfig);
+                                    clock->RequestReschedule();
                             }
                             delete page;
                             page = nullptr;
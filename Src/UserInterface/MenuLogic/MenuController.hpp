@@ -13,6 +13,14 @@
 #include "MenuEvent.h"
 #include "MenuItem.hpp"
 
+// Input handling of the menu, one entry per processed event
+struct MenuStats {
+    uint32_t events = 0;        // Processed events, one render each
+    uint32_t mergedEvents = 0;  // Encoder events folded into another one
+    uint32_t lastLatencyUs = 0; // From the input to the queued render, last event
+    uint32_t maxLatencyUs = 0;  // The same, worst event
+};
+
 enum class MenuState {
     MainScreen,
     MenuScreen,
@@ -22,27 +30,39 @@ enum class MenuState {
 class MenuController {
 public:
     MenuController(Clock* clock, Alarm* alarm, Relay* relay, MenuScreen* menuScreen, IDisplay* display, MenuContent* menuContent);
-    void ProcessEvent(MenuEvent event);
+    // A move by detents; steps is the same with the acceleration
+    // of a fast turn, used by the value fields
+    void ProcessEvent(MenuEvent event, int detents = 1, int steps = 1);
+
+    // Process an encoder event, which stands for mergedEvents + 1 inputs
+    void ProcessEncoderEvent(const EncoderEvent& evt, uint32_t mergedEvents);
+
+    void GetStats(MenuStats& outStats) const { outStats = stats; }
     MenuState GetMenuState() const { return menuState; }
 
 private:
     void DebugEventInput(MenuEvent event, int row, int col);
-    void ProcessMenuEvent(MenuEvent event);
+    void ProcessMenuEvent(MenuEvent event, int detents, int steps);
     void Render();
 
     void SetCurrentItem(MenuItem* item) {
         menuContent->SetCurrentItem(item);
     }
 
-    void SelectNextItem() {
-        menuContent->SelectNextItem();
+    void SelectNextItem(int count) {
+        for (int i = 0; i < count; i++) {
+            menuContent->SelectNextItem();
+        }
     }
 
-    void SelectPrevItem() {
-        menuContent->SelectPrevItem();
+    void SelectPrevItem(int count) {
+        for (int i = 0; i < count; i++) {
+            menuContent->SelectPrevItem();
+        }
     }
 
     MenuState menuState = MenuState::MainScreen;
+    MenuStats stats;
 
     Clock* clock = nullptr;
     Alarm* alarm = nullptr;
@@ -4,4 +4,7 @@ enum class MenuEvent {
     MoveFwd,
     MoveBack,
     PushButton,
+    DoubleClick,    // Applies the page being edited
+    LongPress,      // Leaves the page being edited or the menu
+    HoldRepeat,     // Repeats while the button stays held after a long press
 };
@@ -5,7 +5,6 @@
 enum class MenuItemType {
     Date,
     Time,
-    AlarmTime,
     AlarmConfig,
     Relay,
     System,
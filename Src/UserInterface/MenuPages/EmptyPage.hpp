@@ -29,11 +29,23 @@ EmptyPage(IDisplay* display, int row, int col, const char* headerText)
     virtual void Render() = 0;
 
     
-    EventProcessingResult ProcessMenuEvent(MenuEvent event)
+    EventProcessingResult ProcessMenuEvent(MenuEvent event, int detents, int steps)
     {
+        // The gestures act on the whole page, also while a value is edited
+        switch (event) {
+            case MenuEvent::LongPress:
+                return EventProcessingResult::Cancel;
+            case MenuEvent::DoubleClick:
+                return EventProcessingResult::Apply;
+            case MenuEvent::HoldRepeat:
+                return EventProcessingResult::Continue;
+            default:
+                break;
+        }
+
         if(isEditing)
         {
-            elements[CurrentElementIndex]->ProcessUserInput(event);
+            elements[CurrentElementIndex]->ProcessUserInput(event, detents, steps);
         }
         else
         {
@@ -45,7 +57,10 @@ EmptyPage(IDisplay* display, int row, int col, const char* headerText)
                         return EventProcessingResult::Continue;
                     }
                     
-                    CurrentElementIndex++;
+                    CurrentElementIndex += detents;
+                    if(CurrentElementIndex > MaxStopItemIndex) {
+                        CurrentElementIndex = MaxStopItemIndex;
+                    }
                     break;
 
                 case MenuEvent::MoveBack:
@@ -54,7 +69,10 @@ EmptyPage(IDisplay* display, int row, int col, const char* headerText)
                         return EventProcessingResult::Continue;
                     }
                     
-                    CurrentElementIndex--;
+                    CurrentElementIndex -= detents;
+                    if(CurrentElementIndex < 0) {
+                        CurrentElementIndex = 0;
+                    }
                     break;
 
                 case MenuEvent::PushButton:
@@ -74,6 +92,9 @@ EmptyPage(IDisplay* display, int row, int col, const char* headerText)
                         isEditing = true;
                     }
                     break;
+
+                default:
+                    break;
             }
         }
         
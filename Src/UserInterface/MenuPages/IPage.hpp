@@ -13,6 +13,9 @@ class IPage
 public:
     virtual ~IPage() = default;
     virtual void Render() = 0;
-    virtual void PrepareDisplay();
-    virtual EventProcessingResult ProcessMenuEvent(MenuEvent event) = 0;
+    virtual void PrepareDisplay() = 0;
+    
+    // A move by detents; steps is the same with the acceleration
+    // of a fast turn, the value fields may apply it
+    virtual EventProcessingResult ProcessMenuEvent(MenuEvent event, int detents, int steps) = 0;
 };
@@ -16,7 +16,7 @@ enum class InputElementMode
 class InputElement
 {
     public:
-    using PfnProcessUserInputType = void (*)(void* pPage, MenuEvent event);
+    using PfnProcessUserInputType = void (*)(void* pPage, MenuEvent event, int detents, int steps);
     InputElement(IDisplay* display, int row, int col, InputElementType type, 
                  PfnProcessUserInputType pfnProcessUserInput = nullptr, void* pPage = nullptr)
     : display(display), row(row), col(col), type(type), 
@@ -50,9 +50,11 @@ class InputElement
     InputElementType type;
 
 
-    void ProcessUserInput(MenuEvent event) {
+    // detents is the turn, several when events were merged;
+    // steps is the same with the acceleration, see EncoderEvent
+    void ProcessUserInput(MenuEvent event, int detents, int steps) {
         if (pfnProcessUserInput) {
-            pfnProcessUserInput(pPage, event);
+            pfnProcessUserInput(pPage, event, detents, steps);
         }
     }
 
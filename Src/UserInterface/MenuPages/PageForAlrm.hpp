@@ -1,79 +1,205 @@
 #pragma once
 
 #include "../Display/IDisplay.hpp"
+#include "../Clock/Alarm.hpp"
 
 #include "../MenuLogic/MenuEvent.h"
 #include "InputElement.hpp"
 #include "EmptyPage.hpp"
 
 
+// The page lists all the alarms and edits them one at a time.
+// Layout of the value line (20 columns):
+//   "01 07:00 10s+MTWTFSS"
+//    |  |  |  |  ||
+//    |  |  |  |  |+- weekdays, '-' for the days the alarm is skipped
+//    |  |  |  |  +-- '+' enabled, '-' disabled
+//    |  |  |  +----- duration in seconds
+//    |  +--+-------- time of the alarm
+//    +-------------- number of the alarm
 class PageForAlrm : public EmptyPage
 {
     public:
-    PageForAlrm(IDisplay* display, int row, int col, int seconds, bool enabled, const char* headerText)
-    : EmptyPage(display, row, col, headerText),
-      seconds(seconds), enabled(enabled)
+    PageForAlrm(IDisplay* display, int row, int col, const Alarm* alarm, const char* headerText)
+    : EmptyPage(display, row, col, headerText)
     {
-        elements = new InputElement*[3]; // 2 editable fields + Cancel/Apply
+        // Work on a copy, the alarms are applied all at once
+        configs = new AlarmConfig[Alarm::MaxConfigs];
+        for (int i = 0; i < Alarm::MaxConfigs; i++) {
+            alarm->GetConfig(i, configs[i]);
+        }
+
+        elements = new InputElement*[14]; // 5 editable fields + 7 weekdays + Cancel/Apply
         int i = 0;
         elements[i++] = new InputElement(display, 3, 0, InputElementType::Cancel);
-        elements[i++] = new InputElement(display, row + 1, col + 11, InputElementType::Data, &PageForAlrm::AlterSecondsThunk, this);
-        elements[i++] = new InputElement(display, row + 1, col + 14, InputElementType::Data, &PageForAlrm::SetEnabledThunk, this);
+        elements[i++] = new InputElement(display, row + 1, col + 1, InputElementType::Data, &PageForAlrm::SelectAlarmThunk, this);
+        elements[i++] = new InputElement(display, row + 1, col + 4, InputElementType::Data, &PageForAlrm::AlterHourThunk, this);
+        elements[i++] = new InputElement(display, row + 1, col + 7, InputElementType::Data, &PageForAlrm::AlterMinuteThunk, this);
+        elements[i++] = new InputElement(display, row + 1, col + 10, InputElementType::Data, &PageForAlrm::AlterSecondsThunk, this);
+        elements[i++] = new InputElement(display, row + 1, col + 12, InputElementType::Data, &PageForAlrm::SetEnabledThunk, this);
+        elements[i++] = new InputElement(display, row + 1, col + 13, InputElementType::Data, &PageForAlrm::SetWeekdayThunk<0>, this);
+        elements[i++] = new InputElement(display, row + 1, col + 14, InputElementType::Data, &PageForAlrm::SetWeekdayThunk<1>, this);
+        elements[i++] = new InputElement(display, row + 1, col + 15, InputElementType::Data, &PageForAlrm::SetWeekdayThunk<2>, this);
+        elements[i++] = new InputElement(display, row + 1, col + 16, InputElementType::Data, &PageForAlrm::SetWeekdayThunk<3>, this);
+        elements[i++] = new InputElement(display, row + 1, col + 17, InputElementType::Data, &PageForAlrm::SetWeekdayThunk<4>, this);
+        elements[i++] = new InputElement(display, row + 1, col + 18, InputElementType::Data, &PageForAlrm::SetWeekdayThunk<5>, this);
+        elements[i++] = new InputElement(display, row + 1, col + 19, InputElementType::Data, &PageForAlrm::SetWeekdayThunk<6>, this);
         elements[i++] = new InputElement(display, 3, 0, InputElementType::Apply);
 
         MaxStopItemIndex = i - 1;
     }
 
-    virtual ~PageForAlrm() {}
+    virtual ~PageForAlrm()
+    {
+        delete[] configs;
+    }
 
     void Render()
     {
+        static const char dayNames[] = "MTWTFSS";
+        const AlarmConfig& config = configs[current];
+        CivilTime civil = config.timeBeg.ToCivil();
+
+        char days[8];
+        for (int day = 0; day < 7; day++) {
+            days[day] = config.IsActiveOn(day) ? dayNames[day] : '-';
+        }
+        days[7] = '\0';
+
         char buffer[32];
-        snprintf(buffer, sizeof(buffer), "Duration: %02ds %-3s", seconds, enabled ? "On" : "Off");
+        snprintf(buffer, sizeof(buffer), "%02d %02d:%02d %02ds%c%s",
+            current + 1, civil.hour, civil.minute, config.duration,
+            config.enabled ? '+' : '-', days);
         display->PrintLine(row, col, buffer);
-        
+
         // Render the cursor and options
         RenderElements();
     }
 
-    void SetCurrentState(int seconds, bool enabled)
+    // The edited copy of all the alarms
+    const AlarmConfig* GetAlarmConfigs() const
     {
-        this->seconds = seconds;
-        this->enabled = enabled;
+        return configs;
     }
 
-    void GetCurrentState(int& secondsOut, bool& enabledOut)
-    {
-        secondsOut = seconds;
-        enabledOut = enabled;
+    static void SelectAlarmThunk(void* ctx, MenuEvent event, int detents, int /*steps*/) {
+        static_cast<PageForAlrm*>(ctx)->SelectAlarm(event, detents);
+    }
+
+    static void AlterHourThunk(void* ctx, MenuEvent event, int detents, int /*steps*/) {
+        static_cast<PageForAlrm*>(ctx)->AlterHour(event, detents);
+    }
+
+    static void AlterMinuteThunk(void* ctx, MenuEvent event, int /*detents*/, int steps) {
+        static_cast<PageForAlrm*>(ctx)->AlterMinute(event, steps);
     }
 
-    static void AlterSecondsThunk(void* ctx, MenuEvent event) {
-        static_cast<PageForAlrm*>(ctx)->AlterSeconds(event);
+    static void AlterSecondsThunk(void* ctx, MenuEvent event, int /*detents*/, int steps) {
+        static_cast<PageForAlrm*>(ctx)->AlterSeconds(event, steps);
     }
 
-    static void SetEnabledThunk(void* ctx, MenuEvent event) {
+    static void SetEnabledThunk(void* ctx, MenuEvent event, int /*detents*/, int /*steps*/) {
         static_cast<PageForAlrm*>(ctx)->SetEnabled(event);
     }
 
+    template <int Day>
+    static void SetWeekdayThunk(void* ctx, MenuEvent event, int /*detents*/, int /*steps*/) {
+        static_cast<PageForAlrm*>(ctx)->SetWeekday(Day, event);
+    }
+
+    private:
+    // Select the alarm to edit
+    void SelectAlarm(MenuEvent event, int detents)
+    {
+        switch (event)
+        {
+            case MenuEvent::MoveFwd:
+                current = (current + detents) % Alarm::MaxConfigs;
+                break;
+
+            case MenuEvent::MoveBack:
+                current = (current + Alarm::MaxConfigs - detents % Alarm::MaxConfigs) % Alarm::MaxConfigs;
+                break;
+
+            case MenuEvent::PushButton:
+                // Save the current state and exit editing mode
+                isEditing = false;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    void AlterHour(MenuEvent event, int detents)
+    {
+        switch (event)
+        {
+            case MenuEvent::MoveFwd:
+                configs[current].timeBeg.StepHours(detents, false); // Do not propagate to day
+                break;
+
+            case MenuEvent::MoveBack:
+                configs[current].timeBeg.StepHours(-detents, false); // Do not propagate to day
+                break;
+
+            case MenuEvent::PushButton:
+                // Save the current state and exit editing mode
+                isEditing = false;
+                break;
+
+            default:
+                break;
+        }
+        configs[current].CalcAlarmTimeEnd();
+    }
+
+    void AlterMinute(MenuEvent event, int steps)
+    {
+        switch (event)
+        {
+            case MenuEvent::MoveFwd:
+                configs[current].timeBeg.StepMinutes(steps, false); // Do not propagate to hour
+                break;
+
+            case MenuEvent::MoveBack:
+                configs[current].timeBeg.StepMinutes(-steps, false); // Do not propagate to hour
+                break;
+
+            case MenuEvent::PushButton:
+                // Save the current state and exit editing mode
+                isEditing = false;
+                break;
+
+            default:
+                break;
+        }
+        configs[current].CalcAlarmTimeEnd();
+    }
+
     // Alter the seconds value based on the MenuEvent
     // This function is called when the user interacts with the seconds input element
-    // It increments or decrements the seconds value, or exits editing mode when the button is pushed
+    // It increments or decrements the seconds value by the steps of the turn,
+    // or exits editing mode when the button is pushed
     // Note: The seconds value must be non-negative
     //       and should not exceed a reasonable limit 59 seconds
-    void AlterSeconds(MenuEvent event)
+    void AlterSeconds(MenuEvent event, int steps)
     {
+        int& seconds = configs[current].duration;
+
         switch (event)
         {
             case MenuEvent::MoveFwd:
-                if (seconds < 59) { // Limit to 59 seconds
-                    seconds++;
+                seconds += steps;
+                if (seconds > 59) { // Limit to 59 seconds
+                    seconds = 59;
                 }
                 break;
 
             case MenuEvent::MoveBack:
-                if (seconds > 0) {
-                    seconds--;
+                seconds -= steps;
+                if (seconds < 0) {
+                    seconds = 0;
                 }
                 break;
 
@@ -81,32 +207,62 @@ class PageForAlrm : public EmptyPage
                 // Save the current state and exit editing mode
                 isEditing = false;
                 break;
+
+            default:
+                break;
         }
+        configs[current].CalcAlarmTimeEnd();
     }
 
     // Set the enabled state based on the MenuEvent
     // This function is called when the user interacts with the enabled input element
-    // It toggles the enabled state or exits editing mode when the button is pushed
+    // It sets (forward) or clears (back) the enabled state, any number of detents
+    // has the same effect, or exits editing mode when the button is pushed
     void SetEnabled(MenuEvent event)
     {
         switch (event)
         {
             case MenuEvent::MoveFwd:
-                enabled = true;
+                configs[current].enabled = true;
                 break;
 
             case MenuEvent::MoveBack:
-                enabled = false;
+                configs[current].enabled = false;
                 break;
 
             case MenuEvent::PushButton:
                 // Save the current state and exit editing mode
                 isEditing = false;
                 break;
+
+            default:
+                break;
         }
     }
 
-    private:
-    int seconds;
-    bool enabled;
+    // Include (forward) or skip (back) the day of the week
+    void SetWeekday(int day, MenuEvent event)
+    {
+        switch (event)
+        {
+            case MenuEvent::MoveFwd:
+                configs[current].weekdays |= (1 << day);
+                break;
+
+            case MenuEvent::MoveBack:
+                configs[current].weekdays &= ~(1 << day);
+                break;
+
+            case MenuEvent::PushButton:
+                // Save the current state and exit editing mode
+                isEditing = false;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    AlarmConfig* configs = nullptr;
+    int current = 0; // Index of the alarm on the screen
 };
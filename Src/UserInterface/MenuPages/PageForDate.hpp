@@ -31,7 +31,8 @@ class PageForDate : public EmptyPage
     void Render()
     {
         char buffer[32];
-        snprintf(buffer, sizeof(buffer), "%04d.%02d.%02d", currentValue.year, currentValue.month, currentValue.day);
+        CivilTime civil = currentValue.ToCivil();
+        snprintf(buffer, sizeof(buffer), "%04d.%02d.%02d", civil.year, civil.month, civil.day);
         display->PrintLine(row, col, buffer);
 
         // Render the cursor and options
@@ -43,65 +44,71 @@ class PageForDate : public EmptyPage
         outTime.CopyFrom(currentValue);
     }
 
-    static void AlterYearThunk(void* ctx, MenuEvent event) {
-        static_cast<PageForDate*>(ctx)->AlterYear(event);
+    static void AlterYearThunk(void* ctx, MenuEvent event, int detents, int /*steps*/) {
+        static_cast<PageForDate*>(ctx)->AlterYear(event, detents);
     }
 
-    static void AlterMonthThunk(void* ctx, MenuEvent event) {
-        static_cast<PageForDate*>(ctx)->AlterMonth(event);
+    static void AlterMonthThunk(void* ctx, MenuEvent event, int detents, int /*steps*/) {
+        static_cast<PageForDate*>(ctx)->AlterMonth(event, detents);
     }
 
-    static void AlterDayThunk(void* ctx, MenuEvent event) {
-        static_cast<PageForDate*>(ctx)->AlterDay(event);
+    static void AlterDayThunk(void* ctx, MenuEvent event, int detents, int /*steps*/) {
+        static_cast<PageForDate*>(ctx)->AlterDay(event, detents);
     }
 
     
     private:
-    void AlterDay(MenuEvent event)
+    void AlterDay(MenuEvent event, int detents)
     {
         switch (event) {
             case MenuEvent::MoveFwd:
-                currentValue.IncrementDays();
+                currentValue.AddSeconds(static_cast<int64_t>(detents) * DateTime::SecondsPerDay);
                 break;
             case MenuEvent::MoveBack:
-                currentValue.DecrementDays();
+                currentValue.AddSeconds(-static_cast<int64_t>(detents) * DateTime::SecondsPerDay);
                 break;
             case MenuEvent::PushButton:
                 // Save the current currentValue and exit editing mode
                 isEditing = false;
                 break;
+            default:
+                break;
         }
     }
 
-    void AlterMonth(MenuEvent event)
+    void AlterMonth(MenuEvent event, int detents)
     {
         switch (event) {
             case MenuEvent::MoveFwd:
-                currentValue.IncrementMonths();
+                currentValue.AddMonths(detents);
                 break;
             case MenuEvent::MoveBack:
-                currentValue.DecrementMonths();
+                currentValue.AddMonths(-detents);
                 break;
             case MenuEvent::PushButton:
                 // Save the current currentValue and exit editing mode
                 isEditing = false;
                 break;
+            default:
+                break;
         }
     }
 
-    void AlterYear(MenuEvent event)
+    void AlterYear(MenuEvent event, int detents)
     {
         switch (event) {
             case MenuEvent::MoveFwd:
-                currentValue.IncrementYears();
+                currentValue.AddMonths(12 * detents);
                 break;
             case MenuEvent::MoveBack:
-                currentValue.DecrementYears();
+                currentValue.AddMonths(-12 * detents);
                 break;
             case MenuEvent::PushButton:
                 // Save the current currentValue and exit editing mode
                 isEditing = false;
                 break;
+            default:
+                break;
         }
     }
 
@@ -33,8 +33,10 @@ class PageForRelay : public EmptyPage
     void Render()
     {
         char buffer[21];
+        CivilTime civilOn = timeOn.ToCivil();
+        CivilTime civilOff = timeOff.ToCivil();
         snprintf(buffer, sizeof(buffer), "%02d:%02d - %02d:%02d", 
-            timeOn.hour, timeOn.minute, timeOff.hour, timeOff.minute);
+            civilOn.hour, civilOn.minute, civilOff.hour, civilOff.minute);
 
         display->PrintLine(row, col, buffer);
 
@@ -54,96 +56,108 @@ class PageForRelay : public EmptyPage
         this->timeOff.CopyFrom(timeOff);
     }
 
-    static void AlterHourThunkOn(void* ctx, MenuEvent event) {
-        static_cast<PageForRelay*>(ctx)->AlterHourOn(event);
+    static void AlterHourThunkOn(void* ctx, MenuEvent event, int detents, int /*steps*/) {
+        static_cast<PageForRelay*>(ctx)->AlterHourOn(event, detents);
     }
 
-    static void AlterMinuteThunkOn(void* ctx, MenuEvent event) {
-        static_cast<PageForRelay*>(ctx)->AlterMinuteOn(event);
+    static void AlterMinuteThunkOn(void* ctx, MenuEvent event, int /*detents*/, int steps) {
+        static_cast<PageForRelay*>(ctx)->AlterMinuteOn(event, steps);
     }
 
-    static void AlterHourThunkOff(void* ctx, MenuEvent event) {
-        static_cast<PageForRelay*>(ctx)->AlterHourOff(event);
+    static void AlterHourThunkOff(void* ctx, MenuEvent event, int detents, int /*steps*/) {
+        static_cast<PageForRelay*>(ctx)->AlterHourOff(event, detents);
     }
 
-    static void AlterMinuteThunkOff(void* ctx, MenuEvent event) {
-        static_cast<PageForRelay*>(ctx)->AlterMinuteOff(event);
+    static void AlterMinuteThunkOff(void* ctx, MenuEvent event, int /*detents*/, int steps) {
+        static_cast<PageForRelay*>(ctx)->AlterMinuteOff(event, steps);
     }
 
     private:
-    void AlterHourOn(MenuEvent event)
+    void AlterHourOn(MenuEvent event, int detents)
     {
         switch (event)
         {
             case MenuEvent::MoveFwd:
-                timeOn.IncrementHours(false); // Do not propagate to day
+                timeOn.StepHours(detents, false); // Do not propagate to day
                 break;
 
             case MenuEvent::MoveBack:
-                timeOn.DecrementHours(false); // Do not propagate to day
+                timeOn.StepHours(-detents, false); // Do not propagate to day
                 break;
 
             case MenuEvent::PushButton:
                 // Save the current timeOn and exit editing mode
                 isEditing = false;
                 break;
+
+            default:
+                break;
         }
     }
 
-    void AlterMinuteOn(MenuEvent event)
+    void AlterMinuteOn(MenuEvent event, int steps)
     {
         switch (event)
         {
             case MenuEvent::MoveFwd:
-                timeOn.IncrementMinutes(false); // Do not propagate to hour
+                timeOn.StepMinutes(steps, false); // Do not propagate to hour
                 break;
 
             case MenuEvent::MoveBack:
-                timeOn.DecrementMinutes(false); // Do not propagate to hour
+                timeOn.StepMinutes(-steps, false); // Do not propagate to hour
                 break;
 
             case MenuEvent::PushButton:
                 // Save the current timeOn and exit editing mode
                 isEditing = false;
                 break;
+
+            default:
+                break;
         }
     }
 
-    void AlterHourOff(MenuEvent event)
+    void AlterHourOff(MenuEvent event, int detents)
     {
         switch (event)
         {
             case MenuEvent::MoveFwd:
-                timeOff.IncrementHours(false); // Do not propagate to day
+                timeOff.StepHours(detents, false); // Do not propagate to day
                 break;
 
             case MenuEvent::MoveBack:
-                timeOff.DecrementHours(false); // Do not propagate to day
+                timeOff.StepHours(-detents, false); // Do not propagate to day
                 break;
 
             case MenuEvent::PushButton:
                 // Save the current timeOff and exit editing mode
                 isEditing = false;
                 break;
+
+            default:
+                break;
         }
     }
 
-    void AlterMinuteOff(MenuEvent event)
+    void AlterMinuteOff(MenuEvent event, int steps)
     {
         switch (event)
         {
             case MenuEvent::MoveFwd:
-                timeOff.IncrementMinutes(false); // Do not propagate to hour
+                timeOff.StepMinutes(steps, false); // Do not propagate to hour
                 break;
 
             case MenuEvent::MoveBack:
-                timeOff.DecrementMinutes(false); // Do not propagate to hour
+                timeOff.StepMinutes(-steps, false); // Do not propagate to hour
                 break;
 
             case MenuEvent::PushButton:
                 // Save the current timeOff and exit editing mode
                 isEditing = false;
                 break;
+
+            default:
+                break;
         }
     }
 
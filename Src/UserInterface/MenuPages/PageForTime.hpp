@@ -42,16 +42,18 @@ class PageForTime : public EmptyPage
     void Render()
     {
         char buffer[32];
+        CivilTime civil = currentValue.ToCivil();
+
         // Display the current time in the respective format
         // depending on the mode (with or without seconds)
         switch (mode)
         {
             case PageForTimeMode::WithSeconds:
-                snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", currentValue.hour, currentValue.minute, currentValue.second);
+                snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", civil.hour, civil.minute, civil.second);
                 break;
 
             case PageForTimeMode::WithoutSeconds:
-                snprintf(buffer, sizeof(buffer), "%02d:%02d", currentValue.hour, currentValue.minute);
+                snprintf(buffer, sizeof(buffer), "%02d:%02d", civil.hour, civil.minute);
                 break;
 
             default:
@@ -70,73 +72,82 @@ class PageForTime : public EmptyPage
         outTime.CopyFrom(currentValue);
     }
 
-    static void AlterHourThunk(void* ctx, MenuEvent event) {
-        static_cast<PageForTime*>(ctx)->AlterHour(event);
+    static void AlterHourThunk(void* ctx, MenuEvent event, int detents, int /*steps*/) {
+        static_cast<PageForTime*>(ctx)->AlterHour(event, detents);
     }
 
-    static void AlterMinuteThunk(void* ctx, MenuEvent event) {
-        static_cast<PageForTime*>(ctx)->AlterMinute(event);
+    static void AlterMinuteThunk(void* ctx, MenuEvent event, int /*detents*/, int steps) {
+        static_cast<PageForTime*>(ctx)->AlterMinute(event, steps);
     }
 
-    static void AlterSecondThunk(void* ctx, MenuEvent event) {
-        static_cast<PageForTime*>(ctx)->AlterSecond(event);
+    static void AlterSecondThunk(void* ctx, MenuEvent event, int /*detents*/, int steps) {
+        static_cast<PageForTime*>(ctx)->AlterSecond(event, steps);
     }
 
     private:
-    void AlterHour(MenuEvent event)
+    void AlterHour(MenuEvent event, int detents)
     {
         switch (event)
         {
             case MenuEvent::MoveFwd:
-                currentValue.IncrementHours(false); // Do not propagate to day
+                currentValue.StepHours(detents, false); // Do not propagate to day
                 break;
 
             case MenuEvent::MoveBack:
-                currentValue.DecrementHours(false); // Do not propagate to day
+                currentValue.StepHours(-detents, false); // Do not propagate to day
                 break;
 
             case MenuEvent::PushButton:
                 // Save the current currentValue and exit editing mode
                 isEditing = false;
                 break;
+
+            default:
+                break;
         }
     }
 
-    void AlterMinute(MenuEvent event)
+    void AlterMinute(MenuEvent event, int steps)
     {
         switch (event)
         {
             case MenuEvent::MoveFwd:
-                currentValue.IncrementMinutes(false); // Do not propagate to hour
+                currentValue.StepMinutes(steps, false); // Do not propagate to hour
                 break;
 
             case MenuEvent::MoveBack:
-                currentValue.DecrementMinutes(false); // Do not propagate to hour
+                currentValue.StepMinutes(-steps, false); // Do not propagate to hour
                 break;
 
             case MenuEvent::PushButton:
                 // Save the current currentValue and exit editing mode
                 isEditing = false;
                 break;
+
+            default:
+                break;
         }
     }
 
-    void AlterSecond(MenuEvent event)
+    void AlterSecond(MenuEvent event, int steps)
     {
         switch (event)
         {
             case MenuEvent::MoveFwd:
-                currentValue.IncrementSeconds(false); // Do not propagate to minute/hour
+                currentValue.StepSeconds(steps, false); // Do not propagate to minute/hour
                 break;
 
             case MenuEvent::MoveBack:
-                currentValue.DecrementSeconds(false); // Do not propagate to minute/hour
+                currentValue.StepSeconds(-steps, false); // Do not propagate to minute/hour
                 break;
 
             case MenuEvent::PushButton:
                 // Save the current currentValue and exit editing mode
                 isEditing = false;
                 break;
+
+            default:
+                break;
         }
     }
 